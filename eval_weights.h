@@ -0,0 +1,12 @@
+// The original hand-picked weights, in the layout ./game2 --tune-eval
+// writes (see runEvalTune in m3.cpp). The tuner has not produced a set that
+// beats them yet (51/100 in its verification match); when one does, its
+// output replaces this file. Weights of the clamped, normalized eval terms
+// a b c d e; eval scales the weighted sum by 1000.
+#pragma once
+
+const EvalWeights EVAL_WEIGHTS = {
+    5, // phaseBarriers: c and e are used from this many barriers on
+    { 4.0000, 2.0000, 0.0000, 3.0000, 0.0000 }, // opening
+    { 5.0000, 2.0000, 7.0000, 3.0000, 10.0000 }, // late
+};
@@ -3,6 +3,8 @@
 #include <vector>
 #include <cmath>
 #include <optional>
+#include <fstream>
+#include <string>
 
 using namespace std;
 
@@ -522,29 +524,63 @@ void initializeGame(State& s) {
     s.isMaxTurn = false;  // Human starts
 }
 
+//==================================================
+// Game record (.m3g, the format of m3.cpp's GAME RECORDS)
+//==================================================
+// Appends "start / moves / result" for a game from the initial position;
+// result is ai, hu, or * if the window was closed mid-game.
+void appendGameRecord(const char* path, const State& start, const vector<Move>& moves, const State& final) {
+    ofstream out(path, ios::app);
+    if (!out) return;
+    out << "start " << N << " ai " << start.aiX << ',' << start.aiY << " hu " << start.huX << ',' << start.huY
+        << " tomove " << (start.isMaxTurn ? "ai" : "hu") << "\nmoves";
+    for (const Move& m : moves)
+        out << ' ' << m.moveX << ',' << m.moveY << '/' << m.removeX << ',' << m.removeY;
+    out << "\nresult " << (!hasNoMoves(final) ? "*" : final.isMaxTurn ? "hu" : "ai") << "\n\n";
+}
+
 //==================================================
 // GUI: Board drawing
 //==================================================
-void drawBoard(sf::RenderWindow& win, const State& s) {
-    sf::RectangleShape cell(sf::Vector2f((float)CELL - 2, (float)CELL - 2));
+// The whole board is one sf::VertexArray (two triangles per cell), so a frame
+// is a single draw call. Positions are built once; drawBoard only recolours
+// the cells whose value differs from what the mesh currently shows.
+struct BoardMesh {
+    sf::VertexArray vertices{ sf::PrimitiveType::Triangles, N * N * 6 };
+    int shown[N][N];
+};
+
+sf::Color cellColor(int v) {
+    if (v == BLOCKED) return sf::Color::Black;
+    if (v == AI_PAWN) return sf::Color::Blue;
+    if (v == HU_PAWN) return sf::Color::Red;
+    return sf::Color(180, 180, 180);
+}
+
+void buildBoardMesh(BoardMesh& mesh) {
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < N; j++) {
+            float x0 = (float)(j * CELL + 2), y0 = (float)(i * CELL + 2);
+            float x1 = x0 + CELL - 2,         y1 = y0 + CELL - 2;
+            sf::Vertex* v = &mesh.vertices[(i * N + j) * 6];
+            v[0].position = { x0, y0 }; v[1].position = { x1, y0 }; v[2].position = { x1, y1 };
+            v[3].position = { x0, y0 }; v[4].position = { x1, y1 }; v[5].position = { x0, y1 };
+            mesh.shown[i][j] = EMPTY;
+            for (int k = 0; k < 6; k++) v[k].color = cellColor(EMPTY);
+        }
+    }
+}
 
+void drawBoard(sf::RenderWindow& win, BoardMesh& mesh, const State& s) {
     for (int i = 0; i < N; i++) {
         for (int j = 0; j < N; j++) {
-            int v = s.board[i][j];
-
-            if (v == EMPTY)
-                cell.setFillColor(sf::Color(180, 180, 180));
-            else if (v == BLOCKED)
-                cell.setFillColor(sf::Color::Black);
-            else if (v == AI_PAWN)
-                cell.setFillColor(sf::Color::Blue);
-            else if (v == HU_PAWN)
-                cell.setFillColor(sf::Color::Red);
-
-            cell.setPosition(sf::Vector2f((float)(j * CELL + 2), (float)(i * CELL + 2)));
-            win.draw(cell);
+            if (mesh.shown[i][j] == s.board[i][j]) continue;
+            mesh.shown[i][j] = s.board[i][j];
+            sf::Vertex* v = &mesh.vertices[(i * N + j) * 6];
+            for (int k = 0; k < 6; k++) v[k].color = cellColor(s.board[i][j]);
         }
     }
+    win.draw(mesh.vertices);
 }
 
 //==================================================
@@ -575,20 +611,42 @@ int main() {
     State game;
     initializeGame(game);
 
+    State startPosition = game;
+    State lastComplete = game; // after the last full move (a closed window can leave a step without its barrier)
+    vector<Move> played;
+    bool recorded = false;     // close and game over can both arrive in one loop pass
+    auto recordGame = [&] {
+        if (recorded || played.empty()) return;
+        appendGameRecord("games.m3g", startPosition, played, lastComplete);
+        recorded = true;
+    };
+    Move humanMove{};
+
+    BoardMesh boardMesh;
+    buildBoardMesh(boardMesh);
+
     int depthLimit = DEPTH_LIMIT;
 
     // Human move stage:
     // hStage = 0 -> first select the tile to move to
     // hStage = 1 -> then select the tile to place barrier
     int hStage = 0;
+    bool needsRedraw = true;
 
     while (window.isOpen()) {
 
         // ==========================================================
         // 1. INPUT: User Clicks
         // ==========================================================
-        while (const std::optional<sf::Event> event = window.pollEvent()) {
+        // Waiting for the human: block in waitEvent instead of spinning.
+        // The AI turn and game over need no input, so only poll then.
+        std::optional<sf::Event> event = (needsRedraw || game.isMaxTurn || hasNoMoves(game))
+                                             ? window.pollEvent() : window.waitEvent();
+        for (; event; event = window.pollEvent()) {
+            needsRedraw = true; // clicks, resize, focus: repaint once afterwards
+
             if (event->is<sf::Event::Closed>()) {
+                recordGame();
                 window.close();
             }
 
@@ -617,6 +675,8 @@ int main() {
                         }
                         if (ok) {
                             applyStepMove(game, gx, gy);
+                            humanMove.moveX = gx;
+                            humanMove.moveY = gy;
                             hStage = 1; // Now switch to barrier placement stage
                         }
                     }
@@ -624,7 +684,11 @@ int main() {
                         // --- BARRIER SELECTION ---
                         if (game.board[gx][gy] == EMPTY) {
                             placeBarrier(game, gx, gy);
+                            humanMove.removeX = gx;
+                            humanMove.removeY = gy;
+                            played.push_back(humanMove);
                             game.isMaxTurn = true; // Turn switches to AI
+                            lastComplete = game;
                             hStage = 0;            // Reset stage for Human's next turn
                         }
                     }
@@ -640,13 +704,14 @@ int main() {
         if (hasNoMoves(game)) {
             // Draw final state and end
             window.clear();
-            drawBoard(window, game);
+            drawBoard(window, boardMesh, game);
             
             std::string msg;
             if (game.isMaxTurn) msg = "Game Over: HUMAN Won!";
             else                msg = "Game Over: AI Won!";
             
             std::cout << msg << std::endl;
+            recordGame();
             if (font.getInfo().family != "") {
                 infoText.setString(msg);
                 window.draw(infoText);
@@ -668,7 +733,7 @@ int main() {
 
             // 2. FORCE UPDATE SCREEN (To see the barrier)
             window.clear();
-            drawBoard(window, game);     // Draw current board (with barrier)
+            drawBoard(window, boardMesh, game); // Draw current board (with barrier)
             if (font.getInfo().family != "")
                 window.draw(infoText);
             window.display();            // Push to screen
@@ -679,6 +744,9 @@ int main() {
             // 4. DO HEAVY CALCULATION
             Move ai = findBestMove(game, depthLimit);
             game = applyMove(game, ai);
+            played.push_back(ai);
+            lastComplete = game;
+            needsRedraw = true;
             turns++;
             cout << turns << endl;
         }
@@ -694,11 +762,14 @@ int main() {
         // ==========================================================
         // 3. RENDER: Standard Drawing Loop
         // ==========================================================
-        window.clear();
-        drawBoard(window, game);
-        if (font.getInfo().family != "")
-            window.draw(infoText);
-        window.display();
+        if (needsRedraw) {
+            window.clear();
+            drawBoard(window, boardMesh, game);
+            if (font.getInfo().family != "")
+                window.draw(infoText);
+            window.display();
+            needsRedraw = false;
+        }
     }
 
     return 0;
@@ -1,8 +1,35 @@
+#ifndef M3_LIBRARY // -DM3_LIBRARY: engine and C API only (libm3, see m3.h)
 #include <SFML/Graphics.hpp>
+#endif
 #include <iostream>
 #include <vector>
 #include <cmath>
+#include <algorithm>
 #include <optional>
+#include <string>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <mutex>
+#include <iomanip>
+#include <sstream>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#ifndef _WIN32 // --tt-file (mmap)
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 
@@ -14,11 +41,12 @@ const int CELL = 80;        // Pixel size of each cell
 const int UI_HEIGHT = 40;   // Extra space at bottom for text
 const int DEPTH_LIMIT = 3;  // Minimax depth limit
 
-int turns = 1;       // Number of turns played
+int turns = 1;       // Number of turns played (GUI display)
 
 // FIX 1: Scores are set to massive values to ensure Heuristics never override them.
 const int WIN_SCORE  = 1000000000;
 const int LOSE_SCORE = -1000000000;
+const int DECISIVE_SCORE = WIN_SCORE / 2; // |score| above this = forced win/loss found
 
 enum Cell {
     EMPTY   = 0,
@@ -27,17 +55,120 @@ enum Cell {
     BLOCKED = -1
 };
 
-int dx[8] = { -1,-1,-1, 0, 0, 1, 1, 1 };
-int dy[8] = { -1, 0, 1,-1, 1,-1, 0, 1 };
+constexpr int dx[8] = { -1,-1,-1, 0, 0, 1, 1, 1 };
+constexpr int dy[8] = { -1, 0, 1,-1, 1,-1, 0, 1 };
+// Direction k and 7 - k are opposite, so the neighbour at k sees us at 7 - k.
+
+//==================================================
+// NEIGHBOURHOOD TABLES
+//==================================================
+// Built at compile time for the configured N. A cell's 8 neighbours form a
+// mask (bit k = neighbour dx[k], dy[k]; State.blockedMask keeps the blocked
+// ones), and NEIGHBOURHOOD.byMask[square][mask] answers the local eval terms
+// with one lookup instead of a bounds-checked loop.
+struct NeighbourEntry {
+    uint8_t free;    // in-bounds neighbours not in the mask (legal steps)
+    uint8_t blocked; // in-bounds neighbours in the mask
+};
+
+struct NeighbourhoodTables {
+    NeighbourEntry byMask[N * N][256];
+    uint8_t direction[3][3];   // mask bit of the neighbour at (dx + 1, dy + 1)
+    int positionalPenalty[N * N]; // d_n: 3 * distance from centre + 4 if on the edge
+};
+
+constexpr NeighbourhoodTables makeNeighbourhoodTables() {
+    NeighbourhoodTables t{};
+    for (int k = 0; k < 8; k++) t.direction[dx[k] + 1][dy[k] + 1] = (uint8_t)(1 << k);
+
+    int mid = (N - 1) / 2;
+    for (int x = 0; x < N; x++) {
+        for (int y = 0; y < N; y++) {
+            int sq = x * N + y;
+            int inside = 0;
+            for (int k = 0; k < 8; k++) {
+                int nx = x + dx[k], ny = y + dy[k];
+                if (nx >= 0 && nx < N && ny >= 0 && ny < N) inside |= 1 << k;
+            }
+            for (int mask = 0; mask < 256; mask++) {
+                int freeCount = 0, blockedCount = 0;
+                for (int k = 0; k < 8; k++) {
+                    if (!(inside >> k & 1)) continue;
+                    if (mask >> k & 1) blockedCount++;
+                    else freeCount++;
+                }
+                t.byMask[sq][mask] = { (uint8_t)freeCount, (uint8_t)blockedCount };
+            }
+            bool edge = x == 0 || x == N - 1 || y == 0 || y == N - 1;
+            int centreDist = (x > mid ? x - mid : mid - x) + (y > mid ? y - mid : mid - y);
+            t.positionalPenalty[sq] = 3 * centreDist + (edge ? 4 : 0);
+        }
+    }
+    return t;
+}
+
+constexpr NeighbourhoodTables NEIGHBOURHOOD = makeNeighbourhoodTables();
+
+//==================================================
+// ZOBRIST HASHING
+//==================================================
+// Fixed-seed splitmix64 keys (same scheme as treeV/tree.cpp). State keeps
+// the XOR of its blocked cells and pawn squares in 'hash'; the side to move
+// and anything else a cache depends on are mixed in at lookup.
+struct ZobristTable {
+    uint64_t cell[N][N][3]; // 0: blocked, 1: AI pawn, 2: human pawn
+    uint64_t maxTurn;
+    uint64_t nnue;          // eval cache: position scored by the network
+    uint64_t zone;          // transposition table: searched with the zone barrier set
+};
+
+ZobristTable makeZobrist() {
+    ZobristTable z{};
+    uint64_t x = 0x9E3779B97F4A7C15ull;
+    auto next = [&x] {
+        uint64_t r = (x += 0x9E3779B97F4A7C15ull);
+        r = (r ^ (r >> 30)) * 0xBF58476D1CE4E5B9ull;
+        r = (r ^ (r >> 27)) * 0x94D049BB133111EBull;
+        return r ^ (r >> 31);
+    };
+    for (auto& row : z.cell) for (auto& c : row) for (auto& k : c) k = next();
+    z.maxTurn = next();
+    z.nnue = next();
+    z.zone = next();
+    return z;
+}
+
+const ZobristTable ZOBRIST = makeZobrist();
+
+// FNV-1a over raw bytes, for fingerprints of weights and options
+uint64_t hashBytes(const void* data, size_t size, uint64_t h = 0xCBF29CE484222325ull) {
+    const unsigned char* p = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++) h = (h ^ p[i]) * 0x100000001B3ull;
+    return h;
+}
 
 //==================================================
 // STATE STRUCTURE
 //==================================================
+const int NNUE_HIDDEN = 32; // first-layer width of the neural evaluator (see NNUE section)
+
 struct State {
     int board[N][N];
     int aiX, aiY;
     int huX, huY;
     bool isMaxTurn;  // true = AI (BLUE / MAX), false = Human (RED / MIN)
+
+    // Incremental eval state (see "Distance maps"): kept by the move primitives
+    // and applyMove, so eval reads it instead of rescanning the board.
+    int barriers;                  // blocked cells on the board
+    uint8_t blockedMask[N][N];     // blocked neighbours of every cell (see NEIGHBOURHOOD)
+    uint8_t distAI[N][N];          // BFS distances from each pawn (DIST_UNREACHABLE if cut off)
+    uint8_t distHU[N][N];
+    bool distValid;                // maps match the board (applyMove keeps them up to date)
+    uint64_t hash;                 // Zobrist key of board and pawns (side to move not included)
+
+    alignas(32) int16_t acc[2][NNUE_HIDDEN]; // NNUE first layer per perspective [0 = MIN, 1 = MAX],
+                                             // kept up to date by the move primitives
 };
 
 struct Move {
@@ -45,6 +176,267 @@ struct Move {
     int removeX, removeY;
 };
 
+//==================================================
+// NEURAL EVALUATOR (NNUE)
+//==================================================
+// Inputs are seen from each pawn's perspective (like HalfKP in chess
+// engines): for a perspective with its own pawn on square k, one-hot
+// (k, blocked cell) and (k, opponent pawn square) pairs, N*N * 2*N*N in all.
+// MIN's squares are flipped top-bottom, so both perspectives share one weight
+// table (the rules are symmetric under swapping colours this way).
+// First layer: NNUE_HIDDEN int16 sums of the active inputs' weight rows per
+// perspective (the accumulators in State), updated by the move primitives:
+//  - a barrier adds one row to each accumulator
+//  - a pawn step moves one row in the opponent's accumulator and rebuilds
+//    the mover's own (its k changed; about one row per barrier)
+// Output: clipped ReLU (0..NNUE_QA) of [side to move, other side] dotted
+// with int8 weights: a logit for "side to move wins", returned in eval
+// units from MAX's point of view. Weights come from ./game2 --nnue-train.
+const int NNUE_INPUTS = N * N * 2 * N * N;
+const int NNUE_QA = 127;                 // accumulator scale (1.0 = 127)
+const int NNUE_QB = 64;                  // output weight scale (1.0 = 64)
+const double NNUE_EVAL_SCALE = 5000.0;   // eval units per logit
+const uint32_t NNUE_FILE_VERSION = 2;
+
+struct NnueNetwork {
+    bool loaded = false;
+    alignas(32) int16_t w1[NNUE_INPUTS][NNUE_HIDDEN];
+    alignas(32) int16_t b1[NNUE_HIDDEN];
+    alignas(32) int8_t w2[2 * NNUE_HIDDEN]; // [side to move half | other side half]
+    int32_t b2;
+    uint64_t fingerprint = 0; // hash of the weights (TT keys), set when loaded or trained
+};
+
+void fingerprintNetwork(NnueNetwork& net) {
+    uint64_t h = hashBytes(net.w1, sizeof(net.w1));
+    h = hashBytes(net.b1, sizeof(net.b1), h);
+    h = hashBytes(net.w2, sizeof(net.w2), h);
+    net.fingerprint = hashBytes(&net.b2, sizeof(net.b2), h);
+}
+
+NnueNetwork network;                     // accumulators are maintained while loaded
+const NnueNetwork* evalNetwork = nullptr; // eval uses it when set (per SearchOptions.nnue)
+
+int nnueSquare(bool perspective, int x, int y) { return (perspective ? x : N - 1 - x) * N + y; }
+
+int nnueOwnSquare(const State& s, bool perspective) {
+    return perspective ? nnueSquare(true, s.aiX, s.aiY) : nnueSquare(false, s.huX, s.huY);
+}
+
+// kind: 0 = blocked cell, 1 = opponent pawn
+int nnueFeature(bool perspective, int ownSquare, int kind, int x, int y) {
+    return ownSquare * 2 * N * N + kind * N * N + nnueSquare(perspective, x, y);
+}
+
+void nnueActiveFeatures(const State& s, bool perspective, vector<int>& out) {
+    int own = nnueOwnSquare(s, perspective);
+    for (int i = 0; i < N; i++)
+        for (int j = 0; j < N; j++)
+            if (s.board[i][j] == BLOCKED) out.push_back(nnueFeature(perspective, own, 0, i, j));
+    if (perspective) out.push_back(nnueFeature(true, own, 1, s.huX, s.huY));
+    else             out.push_back(nnueFeature(false, own, 1, s.aiX, s.aiY));
+}
+
+void nnueAddFeature(int16_t* acc, int feature) {
+    const int16_t* row = network.w1[feature];
+#if defined(__AVX2__)
+    for (int k = 0; k < NNUE_HIDDEN; k += 16) {
+        __m256i a = _mm256_load_si256((const __m256i*)(acc + k));
+        __m256i w = _mm256_load_si256((const __m256i*)(row + k));
+        _mm256_store_si256((__m256i*)(acc + k), _mm256_add_epi16(a, w));
+    }
+#else
+    for (int k = 0; k < NNUE_HIDDEN; k++) acc[k] += row[k];
+#endif
+}
+
+void nnueSubFeature(int16_t* acc, int feature) {
+    const int16_t* row = network.w1[feature];
+#if defined(__AVX2__)
+    for (int k = 0; k < NNUE_HIDDEN; k += 16) {
+        __m256i a = _mm256_load_si256((const __m256i*)(acc + k));
+        __m256i w = _mm256_load_si256((const __m256i*)(row + k));
+        _mm256_store_si256((__m256i*)(acc + k), _mm256_sub_epi16(a, w));
+    }
+#else
+    for (int k = 0; k < NNUE_HIDDEN; k++) acc[k] -= row[k];
+#endif
+}
+
+void nnueRefresh(State& s, bool perspective) {
+    memcpy(s.acc[perspective], network.b1, sizeof(s.acc[perspective]));
+    int own = nnueOwnSquare(s, perspective);
+    for (int i = 0; i < N; i++)
+        for (int j = 0; j < N; j++)
+            if (s.board[i][j] == BLOCKED) nnueAddFeature(s.acc[perspective], nnueFeature(perspective, own, 0, i, j));
+    if (perspective) nnueAddFeature(s.acc[1], nnueFeature(true, own, 1, s.huX, s.huY));
+    else             nnueAddFeature(s.acc[0], nnueFeature(false, own, 1, s.aiX, s.aiY));
+}
+
+// Both accumulators from scratch; only needed for positions built cell by cell.
+void nnueRefresh(State& s) {
+    if (!network.loaded) return;
+    nnueRefresh(s, true);
+    nnueRefresh(s, false);
+}
+
+int nnueEvaluate(const State& s) {
+    const NnueNetwork& net = *evalNetwork;
+    const int16_t* halves[2] = { s.acc[s.isMaxTurn], s.acc[!s.isMaxTurn] };
+    int32_t sum = net.b2;
+#if defined(__AVX2__)
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i top = _mm256_set1_epi16(NNUE_QA);
+    __m256i total = _mm256_setzero_si256();
+    for (int half = 0; half < 2; half++) {
+        for (int k = 0; k < NNUE_HIDDEN; k += 16) {
+            __m256i a = _mm256_load_si256((const __m256i*)(halves[half] + k));
+            a = _mm256_min_epi16(_mm256_max_epi16(a, zero), top);
+            __m256i w = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(net.w2 + half * NNUE_HIDDEN + k)));
+            total = _mm256_add_epi32(total, _mm256_madd_epi16(a, w));
+        }
+    }
+    __m128i lanes = _mm_add_epi32(_mm256_castsi256_si128(total), _mm256_extracti128_si256(total, 1));
+    lanes = _mm_add_epi32(lanes, _mm_shuffle_epi32(lanes, _MM_SHUFFLE(1, 0, 3, 2)));
+    lanes = _mm_add_epi32(lanes, _mm_shuffle_epi32(lanes, _MM_SHUFFLE(2, 3, 0, 1)));
+    sum += _mm_cvtsi128_si32(lanes);
+#else
+    for (int half = 0; half < 2; half++) {
+        for (int k = 0; k < NNUE_HIDDEN; k++) {
+            int h = min(max((int)halves[half][k], 0), NNUE_QA);
+            sum += h * net.w2[half * NNUE_HIDDEN + k];
+        }
+    }
+#endif
+    int v = (int)((long long)sum * (long long)NNUE_EVAL_SCALE / (NNUE_QA * NNUE_QB));
+    return s.isMaxTurn ? v : -v;
+}
+
+bool loadNetwork(const string& path) {
+    ifstream in(path, ios::binary);
+    char magic[4];
+    uint32_t version = 0, inputs = 0, hidden = 0;
+    in.read(magic, 4);
+    in.read((char*)&version, 4);
+    in.read((char*)&inputs, 4);
+    in.read((char*)&hidden, 4);
+    if (!in || memcmp(magic, "M3NN", 4) != 0 || version != NNUE_FILE_VERSION ||
+        inputs != (uint32_t)NNUE_INPUTS || hidden != (uint32_t)NNUE_HIDDEN) {
+        cout << "Cannot load network " << path << endl;
+        return false;
+    }
+    in.read((char*)network.w1, sizeof(network.w1));
+    in.read((char*)network.b1, sizeof(network.b1));
+    in.read((char*)network.w2, sizeof(network.w2));
+    in.read((char*)&network.b2, sizeof(network.b2));
+    network.loaded = (bool)in;
+    if (!network.loaded) cout << "Truncated network " << path << endl;
+    fingerprintNetwork(network);
+    return network.loaded;
+}
+
+bool saveNetwork(const string& path) {
+    ofstream out(path, ios::binary);
+    uint32_t header[3] = { NNUE_FILE_VERSION, (uint32_t)NNUE_INPUTS, (uint32_t)NNUE_HIDDEN };
+    out.write("M3NN", 4);
+    out.write((const char*)header, sizeof(header));
+    out.write((const char*)network.w1, sizeof(network.w1));
+    out.write((const char*)network.b1, sizeof(network.b1));
+    out.write((const char*)network.w2, sizeof(network.w2));
+    out.write((const char*)&network.b2, sizeof(network.b2));
+    return (bool)out;
+}
+
+//==================================================
+// SEARCH OPTIONS
+//==================================================
+// Everything that changes how the search prunes lives here, so the GUI,
+// --selfplay and --bench can run different configurations side by side.
+enum SearchEngine {
+    ENGINE_ALPHABETA, // minimax to a fixed depth (findBestMove's 'depth')
+    ENGINE_MCTS       // Monte Carlo tree search for a time budget (see findBestMoveMcts)
+};
+
+enum BarrierMode {
+    BARRIERS_ALL,   // every empty cell (exact)
+    BARRIERS_ZONE   // relevance zone only, verified by a full re-search (see generateAllMoves)
+};
+
+// Eval terms a b c d e (see evalHeuristic), each divided by its MAX_* and clamped to [-1, 1].
+const int EVAL_TERMS = 5;
+
+// Term weights per game phase; the opening leaves c and e at 0 (they are
+// not computed there). Tuned by --tune-eval into eval_weights.h.
+struct EvalWeights {
+    int phaseBarriers;         // late phase from this many barriers on
+    double opening[EVAL_TERMS];
+    double late[EVAL_TERMS];
+};
+
+#include "eval_weights.h"
+
+const int EVAL_CACHE_DEFAULT_LOG2 = 20; // 2^20 entries, 16 MB
+const int TT_DEFAULT_LOG2 = 20;
+
+struct SearchOptions {
+    SearchEngine engine = ENGINE_ALPHABETA;
+    BarrierMode barriers = BARRIERS_ALL;
+    int zoneRadius = 1;     // BARRIERS_ZONE: max Chebyshev distance from either pawn
+    bool collapseDead = true; // one barrier for all cells neither pawn can reach (exact; off with nnue)
+
+    bool orderMoves = false;  // cheap static ordering (see moveOrderKey)
+    bool lmr = false;         // late move reductions at non-PV nodes
+    int lmrFullMoves = 8;     // moves searched at full depth before reducing
+    bool futility = false;    // frontier futility pruning
+    int futilityMargin = 3000; // eval units (1000 = one weighted heuristic point)
+
+    int lowMobilitySteps = 3;  // a pawn with fewer legal steps makes the position forcing
+    bool extensions = false;   // search forcing positions one ply deeper
+    int extensionBudget = 2;   // extensions allowed along one line
+    bool quiescence = false;   // resolve forcing positions at the horizon
+    int quiescencePlies = 4;   // max extra plies below the horizon
+
+    bool probCut = false;      // predict deep cutoffs from a shallow search (see PROBCUT_FITS)
+    double probCutSigmas = 1.5; // cut when the prediction is this many residuals outside the window
+
+    int mctsBudgetMs = 1000;   // ENGINE_MCTS: thinking time per move
+    int mctsThreads = 0;       // 0 = hardware_concurrency
+    int mctsRolloutPlies = 0;  // 0 = play out to the end, else score with eval after this many plies
+    double mctsExploration = 1.5; // PUCT constant
+    int mctsPoolNodes = 1 << 21;  // node pool size; the tree stops growing when it is full
+
+    bool nnue = false;         // evaluate with the loaded network instead of the handcrafted eval
+    const EvalWeights* weights = &EVAL_WEIGHTS; // handcrafted eval weights (--tune-eval matches)
+    bool evalCache = false;    // reuse scores of positions already evaluated (see EvalCache)
+    int evalCacheLog2 = EVAL_CACHE_DEFAULT_LOG2; // cache size: 2^n entries of 16 bytes
+
+    bool tt = false;           // transposition table (see TranspositionTable)
+    int ttLog2 = TT_DEFAULT_LOG2; // table size: 2^n entries of 16 bytes
+    string ttFile;             // the table lives in this shared file (see TT_FILE_VERSION)
+    int multiPv = 1;           // root lines with exact scores (see searchLines)
+};
+
+SearchOptions searchOptions; // configuration used by the GUI game
+
+struct SearchCounters {
+    long long nodes = 0;       // positions visited
+    long long expanded = 0;    // positions whose moves were generated
+    long long generated = 0;   // moves generated at those positions
+    long long researches = 0;  // zone searches redone with all barriers
+    long long reduced = 0;     // LMR: moves searched one ply shallower
+    long long lmrResearches = 0; // LMR: reduced moves that failed high and were re-searched
+    long long futile = 0;      // futility: frontier moves skipped
+    long long extended = 0;    // forced-move extensions granted
+    long long quiescent = 0;   // horizon positions expanded by the quiescence search
+    long long probCuts = 0;    // ProbCut: deep searches replaced by a shallow one
+    long long playouts = 0;    // MCTS: simulations run
+    long long ttCutoffs = 0;   // nodes answered by the transposition table
+    long long cacheHits = 0;   // eval cache probes that found the position
+    long long cacheMisses = 0; // ... and those that did not
+};
+
+thread_local SearchCounters counters; // per thread, so independent searches can run in parallel
+
 //==================================================
 // Helper Functions
 //==================================================
@@ -97,6 +489,16 @@ bool placeBarrier(State& s, int x, int y) {
     if (!inBounds(x, y)) return false;
     if (s.board[x][y] != EMPTY) return false;
     s.board[x][y] = BLOCKED;
+
+    s.barriers++;
+    s.hash ^= ZOBRIST.cell[x][y][0];
+    for (int k = 0; k < 8; k++)
+        if (inBounds(x + dx[k], y + dy[k])) s.blockedMask[x + dx[k]][y + dy[k]] |= 1 << (7 - k);
+    s.distValid = false;
+    if (network.loaded) {
+        nnueAddFeature(s.acc[1], nnueFeature(true, nnueOwnSquare(s, true), 0, x, y));
+        nnueAddFeature(s.acc[0], nnueFeature(false, nnueOwnSquare(s, false), 0, x, y));
+    }
     return true;
 }
 
@@ -113,32 +515,243 @@ void applyStepMove(State& s, int toX, int toY) {
 
     if (s.isMaxTurn) { s.aiX = toX; s.aiY = toY; }
     else             { s.huX = toX; s.huY = toY; }
+    s.distValid = false;
+    int piece = s.isMaxTurn ? 1 : 2;
+    s.hash ^= ZOBRIST.cell[px][py][piece] ^ ZOBRIST.cell[toX][toY][piece];
+
+    if (network.loaded) {
+        bool mover = s.isMaxTurn;
+        int opponentOwn = nnueOwnSquare(s, !mover);
+        nnueRefresh(s, mover);
+        nnueSubFeature(s.acc[!mover], nnueFeature(!mover, opponentOwn, 1, px, py));
+        nnueAddFeature(s.acc[!mover], nnueFeature(!mover, opponentOwn, 1, toX, toY));
+    }
+}
+
+//==================================================
+// Distance maps
+//==================================================
+// BFS distances from each pawn through non-blocked cells (pawns do not block).
+// State caches both maps. After a move the mover's map is rebuilt (its source
+// moved), while the opponent's only lost one cell, so repairDistances fixes
+// just the cells whose shortest paths all ran through the new barrier.
+const uint8_t DIST_UNREACHABLE = 255;
+
+void bfsDistances(const State& s, int startX, int startY, int distMap[N][N]) {
+    for (int i = 0; i < N; ++i)
+        for (int j = 0; j < N; ++j)
+            distMap[i][j] = 999;
+
+    std::vector<std::pair<int,int>> q;
+    q.push_back({startX, startY});
+    distMap[startX][startY] = 0;
+
+    size_t head = 0;
+    while (head < q.size()) {
+        auto [cx, cy] = q[head++];
+        int currentDist = distMap[cx][cy];
+
+        for (int k = 0; k < 8; ++k) {
+            int nx = cx + dx[k];
+            int ny = cy + dy[k];
+
+            if (!inBounds(nx, ny)) continue;
+            if (s.board[nx][ny] == BLOCKED) continue;
+
+            if (distMap[nx][ny] > currentDist + 1) {
+                distMap[nx][ny] = currentDist + 1;
+                q.push_back({nx, ny});
+            }
+        }
+    }
+}
+
+void bfsDistances(const State& s, int startX, int startY, uint8_t dist[N][N]) {
+    memset(dist, DIST_UNREACHABLE, N * N);
+    int queue[N * N][2];
+    int head = 0, tail = 0;
+    queue[tail][0] = startX; queue[tail][1] = startY; tail++;
+    dist[startX][startY] = 0;
+
+    while (head < tail) {
+        int cx = queue[head][0], cy = queue[head][1];
+        head++;
+        for (int k = 0; k < 8; ++k) {
+            int nx = cx + dx[k];
+            int ny = cy + dy[k];
+            if (!inBounds(nx, ny) || s.board[nx][ny] == BLOCKED) continue;
+            if (dist[nx][ny] == DIST_UNREACHABLE) {
+                dist[nx][ny] = dist[cx][cy] + 1;
+                queue[tail][0] = nx; queue[tail][1] = ny; tail++;
+            }
+        }
+    }
+}
+
+// The cell (bx, by) was just blocked; distances can only grow.
+void repairDistances(const State& s, uint8_t dist[N][N], int bx, int by) {
+    int db = dist[bx][by];
+    dist[bx][by] = DIST_UNREACHABLE;
+    if (db == DIST_UNREACHABLE) return;
+
+    // 1) Cells left without a neighbour one step closer, in increasing distance
+    //    (FIFO order finishes a layer before the next one is checked).
+    bool lost[N][N] = {};
+    bool queued[N][N] = {};
+    int queue[N * N][2];
+    int head = 0, tail = 0;
+    auto pushDownstream = [&](int x, int y, int d) {
+        for (int k = 0; k < 8; k++) {
+            int nx = x + dx[k], ny = y + dy[k];
+            if (inBounds(nx, ny) && !queued[nx][ny] && s.board[nx][ny] != BLOCKED && dist[nx][ny] == d + 1) {
+                queued[nx][ny] = true;
+                queue[tail][0] = nx; queue[tail][1] = ny; tail++;
+            }
+        }
+    };
+    pushDownstream(bx, by, db);
+    int lostCells[N * N][2];
+    int lostCount = 0;
+    while (head < tail) {
+        int cx = queue[head][0], cy = queue[head][1];
+        head++;
+        bool supported = false;
+        for (int k = 0; k < 8 && !supported; k++) {
+            int nx = cx + dx[k], ny = cy + dy[k];
+            supported = inBounds(nx, ny) && s.board[nx][ny] != BLOCKED && !lost[nx][ny] &&
+                        dist[nx][ny] + 1 == dist[cx][cy];
+        }
+        if (supported) continue;
+        lost[cx][cy] = true;
+        lostCells[lostCount][0] = cx; lostCells[lostCount][1] = cy; lostCount++;
+        pushDownstream(cx, cy, dist[cx][cy]);
+    }
+    if (lostCount == 0) return;
+
+    // 2) Lost cells restart from their intact neighbours, relaxed among
+    //    themselves until nothing improves (a cell is queued at most once at a time).
+    head = tail = 0;
+    memset(queued, 0, sizeof(queued));
+    for (int k = 0; k < lostCount; k++) dist[lostCells[k][0]][lostCells[k][1]] = DIST_UNREACHABLE;
+    for (int k = 0; k < lostCount; k++) {
+        int cx = lostCells[k][0], cy = lostCells[k][1];
+        int best = DIST_UNREACHABLE;
+        for (int j = 0; j < 8; j++) {
+            int nx = cx + dx[j], ny = cy + dy[j];
+            if (inBounds(nx, ny) && s.board[nx][ny] != BLOCKED && !lost[nx][ny] && dist[nx][ny] != DIST_UNREACHABLE)
+                best = min(best, dist[nx][ny] + 1);
+        }
+        if (best == DIST_UNREACHABLE) continue;
+        dist[cx][cy] = (uint8_t)best;
+        queued[cx][cy] = true;
+        queue[tail][0] = cx; queue[tail][1] = cy; tail = (tail + 1) % (N * N);
+    }
+    while (head != tail) {
+        int cx = queue[head][0], cy = queue[head][1];
+        head = (head + 1) % (N * N);
+        queued[cx][cy] = false;
+        for (int j = 0; j < 8; j++) {
+            int nx = cx + dx[j], ny = cy + dy[j];
+            if (!inBounds(nx, ny) || !lost[nx][ny] || dist[nx][ny] <= dist[cx][cy] + 1) continue;
+            dist[nx][ny] = dist[cx][cy] + 1;
+            if (!queued[nx][ny]) {
+                queued[nx][ny] = true;
+                queue[tail][0] = nx; queue[tail][1] = ny; tail = (tail + 1) % (N * N);
+            }
+        }
+    }
+}
+
+// Both maps from scratch (positions set up cell by cell)
+void refreshDistances(State& s) {
+    bfsDistances(s, s.aiX, s.aiY, s.distAI);
+    bfsDistances(s, s.huX, s.huY, s.distHU);
+    s.distValid = true;
+}
+
+// int maps (999 = unreachable) for the search code, from the cache when valid
+void distanceMaps(const State& s, int distAI[N][N], int distHU[N][N]) {
+    if (!s.distValid) {
+        bfsDistances(s, s.aiX, s.aiY, distAI);
+        bfsDistances(s, s.huX, s.huY, distHU);
+        return;
+    }
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < N; j++) {
+            distAI[i][j] = s.distAI[i][j] == DIST_UNREACHABLE ? 999 : s.distAI[i][j];
+            distHU[i][j] = s.distHU[i][j] == DIST_UNREACHABLE ? 999 : s.distHU[i][j];
+        }
+    }
 }
 
 //==================================================
 // Apply full move (move + barrier, switch turn)
 //  -> Used ONLY for AI.
 //==================================================
+// Children of one position. The mover's map after a step is the same for
+// every barrier that follows it, so it is computed once per step direction
+// and only repaired for the barrier; the opponent's map (pawns do not block)
+// is repaired from the parent's.
+struct ChildMaker {
+    const State& parent;
+    bool stepDone[8] = {};
+    uint8_t stepDist[8][N][N];
+
+    explicit ChildMaker(const State& s) : parent(s) {}
+
+    State apply(const Move& m) {
+        State ns = parent;
+        applyStepMove(ns, m.moveX, m.moveY);
+
+        bool moverMax = parent.isMaxTurn;
+        int k = 0;
+        if (parent.distValid) {
+            int px, py;
+            getCurrentPlayerPos(parent, px, py);
+            while (k < 7 && (px + dx[k] != m.moveX || py + dy[k] != m.moveY)) k++;
+            if (!stepDone[k]) {
+                bfsDistances(ns, m.moveX, m.moveY, stepDist[k]);
+                stepDone[k] = true;
+            }
+        }
+
+        placeBarrier(ns, m.removeX, m.removeY);
+        ns.isMaxTurn = !parent.isMaxTurn;
+
+        if (!parent.distValid) {
+            refreshDistances(ns);
+            return ns;
+        }
+        uint8_t (*moverDist)[N] = moverMax ? ns.distAI : ns.distHU;
+        uint8_t (*opponentDist)[N] = moverMax ? ns.distHU : ns.distAI;
+        memcpy(moverDist, stepDist[k], sizeof(stepDist[k]));
+        repairDistances(ns, moverDist, m.removeX, m.removeY);
+        repairDistances(ns, opponentDist, m.removeX, m.removeY);
+        ns.distValid = true;
+        return ns;
+    }
+};
+
 State applyMove(const State& s, const Move& m) {
-    State ns = s;
-    applyStepMove(ns, m.moveX, m.moveY);
-    placeBarrier(ns, m.removeX, m.removeY);
-    ns.isMaxTurn = !s.isMaxTurn;
-    return ns;
+    return ChildMaker(s).apply(m);
 }
 
 //==================================================
 // Move counting / terminal test
 //==================================================
-bool hasNoMoves(const State& s) {
-    return getLegalStepMoves(s).empty();
+// Legal steps in O(1): free in-bounds neighbours, with the other pawn added to the mask.
+int countMovesForPlayer(const State& s, bool forAI) {
+    int x = forAI ? s.aiX : s.huX;
+    int y = forAI ? s.aiY : s.huY;
+    int ox = (forAI ? s.huX : s.aiX) - x;
+    int oy = (forAI ? s.huY : s.aiY) - y;
+    int mask = s.blockedMask[x][y];
+    if (ox >= -1 && ox <= 1 && oy >= -1 && oy <= 1) mask |= NEIGHBOURHOOD.direction[ox + 1][oy + 1];
+    return NEIGHBOURHOOD.byMask[x * N + y][mask].free;
 }
 
-int countMovesForPlayer(const State& s, bool forAI) {
-    State tmp = s;
-    tmp.isMaxTurn = forAI;
-    auto mv = getLegalStepMoves(tmp);
-    return (int)mv.size();
+bool hasNoMoves(const State& s) {
+    return countMovesForPlayer(s, s.isMaxTurn) == 0;
 }
 
 //==================================================
@@ -154,79 +767,28 @@ int calculateMobility(const State& s) {
 
 // b_n: Barrier Effect
 int calculateBarriers(const State& s) {
-    int blockedAroundAI = 0;
-    int blockedAroundHU = 0;
-
-    // --- Blocks around AI (Max) ---
-    {
-        State temp = s;
-        temp.isMaxTurn = true;
-        int ax, ay;
-        getCurrentPlayerPos(temp, ax, ay);
-
-        for (int k = 0; k < 8; k++) {
-            int nx = ax + dx[k];
-            int ny = ay + dy[k];
-            if (inBounds(nx, ny) && s.board[nx][ny] == BLOCKED) {
-                blockedAroundAI++;
-            }
-        }
-    }
-
-    // --- Blocks around Human (Min) ---
-    {
-        State temp = s;
-        temp.isMaxTurn = false;
-        int hx, hy;
-        getCurrentPlayerPos(temp, hx, hy);
-
-        for (int k = 0; k < 8; k++) {
-            int nx = hx + dx[k];
-            int ny = hy + dy[k];
-            if (inBounds(nx, ny) && s.board[nx][ny] == BLOCKED) {
-                blockedAroundHU++;
-            }
-        }
-    }
+    int blockedAroundAI = NEIGHBOURHOOD.byMask[s.aiX * N + s.aiY][s.blockedMask[s.aiX][s.aiY]].blocked;
+    int blockedAroundHU = NEIGHBOURHOOD.byMask[s.huX * N + s.huY][s.blockedMask[s.huX][s.huY]].blocked;
     return (blockedAroundHU - blockedAroundAI);
 }
 
-// c_n: Voronoi Territory
-void bfsDistances(const State& s, int startX, int startY, int distMap[N][N]) {
-    for (int i = 0; i < N; ++i)
-        for (int j = 0; j < N; ++j)
-            distMap[i][j] = 999;
-
-    std::vector<std::pair<int,int>> q;
-    q.push_back({startX, startY});
-    distMap[startX][startY] = 0;
-
-    size_t head = 0;
-    while (head < q.size()) {
-        auto [cx, cy] = q[head++];
-        int currentDist = distMap[cx][cy];
-
-        for (int k = 0; k < 8; ++k) {
-            int nx = cx + dx[k];
-            int ny = cy + dy[k];
-
-            if (!inBounds(nx, ny)) continue;
-            if (s.board[nx][ny] == BLOCKED) continue;
-
-            if (distMap[nx][ny] > currentDist + 1) {
-                distMap[nx][ny] = currentDist + 1;
-                q.push_back({nx, ny});
+// c_n: Voronoi Territory (distance maps: see "Distance maps")
+int calculateVoronoi(const State& s) {
+    if (s.distValid) {
+        int score = 0;
+        for (int i = 0; i < N; ++i) {
+            for (int j = 0; j < N; ++j) {
+                int a = s.distAI[i][j], h = s.distHU[i][j]; // blocked cells are unreachable for both
+                if (a < h) score++;
+                else if (h < a) score--;
             }
         }
+        return score;
     }
-}
 
-int calculateVoronoi(const State& s) {
     int distAI[N][N];
     int distHU[N][N];
-
-    bfsDistances(s, s.aiX, s.aiY, distAI);
-    bfsDistances(s, s.huX, s.huY, distHU);
+    distanceMaps(s, distAI, distHU);
 
     int score = 0;
 
@@ -245,26 +807,9 @@ int calculateVoronoi(const State& s) {
     return score;
 }
 
-// d_n: Positional score
+// d_n: Positional score (centre distance weight 3, edge weight 4; see NEIGHBOURHOOD)
 int calculatePositional(const State& s) {
-    int mid = (N - 1) / 2;
-    int aiDist = std::abs(s.aiX - mid) + std::abs(s.aiY - mid);
-    int huDist = std::abs(s.huX - mid) + std::abs(s.huY - mid);
-
-    int centerWeight = 3;
-    int centerScore = centerWeight * (huDist - aiDist);
-
-    auto edgePenalty = [&](int x, int y) {
-        if (x == 0 || x == N - 1 || y == 0 || y == N - 1) return 1;
-        return 0;
-    };
-
-    int aiEdge = edgePenalty(s.aiX, s.aiY);
-    int huEdge = edgePenalty(s.huX, s.huY);
-    int edgeWeight = 4;
-    int edgeScore = edgeWeight * (huEdge - aiEdge);
-
-    return centerScore + edgeScore;
+    return NEIGHBOURHOOD.positionalPenalty[s.huX * N + s.huY] - NEIGHBOURHOOD.positionalPenalty[s.aiX * N + s.aiY];
 }
 
 // e_n: Local space
@@ -295,8 +840,22 @@ int countLocalSpaceAround(const State& s, int sx, int sy, int maxDist) {
     return count;
 }
 
+// From the cached maps: cells at distance 1..maxDist, i.e. what
+// countLocalSpaceAround's bounded BFS visits.
+int countLocalSpaceCached(const uint8_t dist[N][N], int sx, int sy, int maxDist) {
+    int count = 0;
+    for (int i = max(0, sx - maxDist); i <= min(N - 1, sx + maxDist); i++)
+        for (int j = max(0, sy - maxDist); j <= min(N - 1, sy + maxDist); j++)
+            if (dist[i][j] >= 1 && dist[i][j] <= maxDist) count++;
+    return count;
+}
+
 int calculateLocalSpace(const State& s) {
     int maxDist = 2;
+    if (s.distValid) {
+        return countLocalSpaceCached(s.distAI, s.aiX, s.aiY, maxDist) -
+               countLocalSpaceCached(s.distHU, s.huX, s.huY, maxDist);
+    }
     int aiSpace = countLocalSpaceAround(s, s.aiX, s.aiY, maxDist);
     int huSpace = countLocalSpaceAround(s, s.huX, s.huY, maxDist);
     return aiSpace - huSpace;
@@ -308,193 +867,2426 @@ const double MAX_VORONOI_DIFF     = 49.0;
 const double MAX_POSITIONAL_ABS   = 22.0;
 const double MAX_LOCAL_SPACE_DIFF = 24.0;
 
-//==================================================
-// FIX 2: Added 'depth' parameter to eval function
-//==================================================
-int eval(const State& s, int depth) {
-    
-    // 1) Terminal state: Win/Loss check
-    if (hasNoMoves(s)) {
-        if (s.isMaxTurn) {
-            // AI cannot move -> LOST
-            // Subtract depth to try and prolong the game (delaying the loss)
-            return LOSE_SCORE - depth;
-        } else {
-            // Human cannot move -> AI WON
-            // Add depth to prefer winning IMMEDIATELY.
-            // The larger the depth (closer to current turn), the higher the score.
-            return WIN_SCORE + depth;
-        }
-    }
-
-    // 2) Heuristic calculations (If game continues)
-    int blockedApprox = 2 * turns - 1;
-
-    int a = calculateMobility(s);
-    int b = calculateBarriers(s);
-    int d = calculatePositional(s);
+const EvalWeights* evalWeights = &EVAL_WEIGHTS; // per SearchOptions.weights, set together with evalNetwork
 
+void evalTerms(const State& s, bool late, double t[EVAL_TERMS]) {
     auto clamp = [](double v) {
         if (v >  1.0) return  1.0;
         if (v < -1.0) return -1.0;
         return v;
     };
 
-    double na = clamp(static_cast<double>(a) / MAX_MOBILITY_DIFF);
-    double nb = clamp(static_cast<double>(b) / MAX_BARRIER_DIFF);
-    double nd = clamp(static_cast<double>(d) / MAX_POSITIONAL_ABS);
-
-    double score = 0.0;
+    t[0] = clamp(static_cast<double>(calculateMobility(s)) / MAX_MOBILITY_DIFF);
+    t[1] = clamp(static_cast<double>(calculateBarriers(s)) / MAX_BARRIER_DIFF);
+    t[2] = late ? clamp(static_cast<double>(calculateVoronoi(s)) / MAX_VORONOI_DIFF) : 0.0;
+    t[3] = clamp(static_cast<double>(calculatePositional(s)) / MAX_POSITIONAL_ABS);
+    t[4] = late ? clamp(static_cast<double>(calculateLocalSpace(s)) / MAX_LOCAL_SPACE_DIFF) : 0.0;
+}
 
-    if (blockedApprox < 5) {
-        score = 4.0 * na + 2.0 * nb + 3.0 * nd;
-    } 
-    else {
-        int c = calculateVoronoi(s);
-        int e = calculateLocalSpace(s);
-        double nc = clamp(static_cast<double>(c) / MAX_VORONOI_DIFF);
-        double ne = clamp(static_cast<double>(e) / MAX_LOCAL_SPACE_DIFF);
+// 2) Heuristic calculations (if the game continues)
+int evalHeuristic(const State& s) {
+    // Game phase from the real barrier count (was 2 * turns - 1, which stays
+    // fixed for the whole search tree while every ply adds a barrier)
+    bool late = s.barriers >= evalWeights->phaseBarriers;
+    const double* w = late ? evalWeights->late : evalWeights->opening;
 
-        score = 5.0 * na + 2.0 * nb + 7.0 * nc + 3.0 * nd + 10.0 * ne;
-    }
+    double t[EVAL_TERMS];
+    evalTerms(s, late, t);
+    double score = 0.0;
+    for (int i = 0; i < EVAL_TERMS; i++) score += w[i] * t[i];
 
     // FIX 3: Multiplier reduced (from 100,000 to 1,000)
     // This ensures the Heuristic score never reaches the WIN_SCORE.
     return static_cast<int>(score * 1000.0);
 }
 
-
 //==================================================
-// Successor: generate all moves (move + barrier) - for AI
+// Eval cache
 //==================================================
-vector<Move> generateAllMoves(const State& s) {
-    vector<Move> res;
-    auto steps = getLegalStepMoves(s);
+// Direct-mapped and lossy: a new score simply overwrites the slot. Entries
+// are two independent atomics holding (key ^ score, score), so a slot torn
+// by two threads writing at once fails the key check instead of returning
+// the wrong score; no locks, relaxed loads and stores. Terminal positions
+// never get here (their score depends on the depth). Off by default
+// (--eval-cache): eval reads the incrementally kept State, so a hit saves
+// about what the random access into the table costs. Hits and misses are
+// counted in the thread's SearchCounters, not here: a shared counter would
+// bounce one cache line between all searching cores on every eval.
+struct EvalCacheEntry {
+    atomic<uint64_t> check{0}; // key ^ data
+    atomic<uint64_t> data{0};  // score (as uint32)
+};
 
-    for (auto p : steps) {
-        int mx = p.first, my = p.second;
-        State after = s;
-        applyStepMove(after, mx, my);
+struct EvalCache {
+    unique_ptr<EvalCacheEntry[]> entries;
+    size_t mask = 0;
 
-        for (int i = 0; i < N; i++) {
-            for (int j = 0; j < N; j++) {
-                if (after.board[i][j] == EMPTY) {
-                    Move m{mx, my, i, j};
-                    res.push_back(m);
-                }
-            }
+    void resize(int log2Entries) {
+        entries.reset(new EvalCacheEntry[(size_t)1 << log2Entries]);
+        mask = ((size_t)1 << log2Entries) - 1;
+    }
+
+    void clear() {
+        for (size_t i = 0; entries && i <= mask; i++) {
+            entries[i].check.store(0, memory_order_relaxed);
+            entries[i].data.store(0, memory_order_relaxed);
         }
     }
-    return res;
-}
 
-//==================================================
-// FIX 4: Minimax now passes 'depth' to eval
-//==================================================
-int minimax(const State& s, int depth, int alpha, int beta) {
+    bool probe(uint64_t key, int& score) {
+        const EvalCacheEntry& e = entries[key & mask];
+        uint64_t data = e.data.load(memory_order_relaxed);
+        if ((e.check.load(memory_order_relaxed) ^ data) == key) {
+            counters.cacheHits++;
+            score = (int)(int32_t)(uint32_t)data;
+            return true;
+        }
+        counters.cacheMisses++;
+        return false;
+    }
+
+    void store(uint64_t key, int score) {
+        EvalCacheEntry& e = entries[key & mask];
+        uint64_t data = (uint32_t)(int32_t)score;
+        e.data.store(data, memory_order_relaxed);
+        e.check.store(key ^ data, memory_order_relaxed);
+    }
+};
+
+EvalCache evalCache;
+bool evalCacheEnabled = false; // per SearchOptions.evalCache, set together with evalNetwork
+
+//==================================================
+// FIX 2: Added 'depth' parameter to eval function
+//==================================================
+int eval(const State& s, int depth) {
+    
+    // 1) Terminal state: Win/Loss check
+    if (hasNoMoves(s)) {
+        if (s.isMaxTurn) {
+            // AI cannot move -> LOST
+            // Subtract depth to try and prolong the game (delaying the loss)
+            return LOSE_SCORE - depth;
+        } else {
+            // Human cannot move -> AI WON
+            // Add depth to prefer winning IMMEDIATELY.
+            // The larger the depth (closer to current turn), the higher the score.
+            return WIN_SCORE + depth;
+        }
+    }
+
+    uint64_t cacheKey = s.hash ^ (s.isMaxTurn ? ZOBRIST.maxTurn : 0) ^ (evalNetwork ? ZOBRIST.nnue : 0);
+    int cached;
+    if (evalCacheEnabled && evalCache.probe(cacheKey, cached)) return cached;
+
+    int score = evalNetwork ? nnueEvaluate(s) : evalHeuristic(s);
+    if (evalCacheEnabled) evalCache.store(cacheKey, score);
+    return score;
+}
+
+
+//==================================================
+// Successor: generate all moves (move + barrier) - for AI
+//==================================================
+// Dead cells (reachable by neither pawn) are collapsed to one representative
+// per step. With the handcrafted eval this is exact: none of its terms looks
+// at a dead cell (mobility and barrier counts only see cells next to a pawn,
+// and Voronoi / local space only see reachable cells), and barriers only
+// shrink the reachable area, so a dead cell stays dead. Every dead-cell
+// barrier therefore leads to the same search result, and the scan order
+// keeps the move the full list would pick. The network sees every blocked
+// cell (one input per cell and pawn square), so with opt.nnue each dead
+// barrier scores differently and nothing is collapsed.
+// Cells reachable by only one pawn are NOT collapsed: mobility, barrier count
+// and local space all depend on where inside that region the barrier lands.
+//
+// BARRIERS_ZONE keeps only barriers that can matter soon:
+//  - within opt.zoneRadius (Chebyshev) of either pawn after the step, or
+//  - on the contested Voronoi frontier: reachable by both pawns with
+//    distances differing by at most 1 (computed once per position).
+// If that leaves no barrier for a step, all empty cells are used.
+// The reduction is not exact; findBestMove re-searches with all barriers
+// when the zone search reports a forced win or loss.
+void markBarrierZone(const State& s, const SearchOptions& opt,
+                     const int distAI[N][N], const int distHU[N][N], bool zone[N][N]) {
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < N; j++) {
+            bool contested = distAI[i][j] != 999 && distHU[i][j] != 999 &&
+                             abs(distAI[i][j] - distHU[i][j]) <= 1;
+            bool nearOpponent = max(abs(i - (s.isMaxTurn ? s.huX : s.aiX)),
+                                    abs(j - (s.isMaxTurn ? s.huY : s.aiY))) <= opt.zoneRadius;
+            zone[i][j] = contested || nearOpponent;
+        }
+    }
+}
+
+vector<Move> generateAllMoves(const State& s, const SearchOptions& opt) {
+    vector<Move> res;
+    auto steps = getLegalStepMoves(s);
+
+    bool useZone = (opt.barriers == BARRIERS_ZONE);
+    bool collapseDead = opt.collapseDead && !opt.nnue;
+    int distAI[N][N];
+    int distHU[N][N];
+    bool zone[N][N];
+    if (useZone || collapseDead) {
+        // A step stays inside the mover's region, so these hold for every step
+        distanceMaps(s, distAI, distHU);
+    }
+    if (useZone) markBarrierZone(s, opt, distAI, distHU, zone);
+
+    for (auto p : steps) {
+        int mx = p.first, my = p.second;
+        State after = s;
+        applyStepMove(after, mx, my);
+
+        bool deadTaken = false;
+        auto addBarrier = [&](int i, int j) {
+            if (collapseDead && distAI[i][j] == 999 && distHU[i][j] == 999) {
+                if (deadTaken) return;
+                deadTaken = true;
+            }
+            res.push_back({mx, my, i, j});
+        };
+
+        size_t first = res.size();
+        for (int i = 0; i < N; i++) {
+            for (int j = 0; j < N; j++) {
+                if (after.board[i][j] != EMPTY) continue;
+                if (useZone && !zone[i][j] && max(abs(i - mx), abs(j - my)) > opt.zoneRadius) continue;
+                addBarrier(i, j);
+            }
+        }
+
+        if (useZone && res.size() == first) {
+            for (int i = 0; i < N; i++)
+                for (int j = 0; j < N; j++)
+                    if (after.board[i][j] == EMPTY) addBarrier(i, j);
+        }
+    }
+    return res;
+}
+
+//==================================================
+// Move ordering
+//==================================================
+// No eval per move (eval runs BFS): barriers close to the opponent first,
+// barriers right next to the mover's new square last, and among steps the
+// ones to squares with more free neighbours first.
+int moveOrderKey(const State& s, const Move& m) {
+    int ox = s.isMaxTurn ? s.huX : s.aiX;
+    int oy = s.isMaxTurn ? s.huY : s.aiY;
+    int px, py;
+    getCurrentPlayerPos(s, px, py);
+
+    int dOpp = max(abs(m.removeX - ox), abs(m.removeY - oy));
+    int dOwn = max(abs(m.removeX - m.moveX), abs(m.removeY - m.moveY));
+
+    int freeAround = 0;
+    for (int k = 0; k < 8; k++) {
+        int nx = m.moveX + dx[k];
+        int ny = m.moveY + dy[k];
+        if (!inBounds(nx, ny) || (nx == m.removeX && ny == m.removeY)) continue;
+        if (s.board[nx][ny] == EMPTY || (nx == px && ny == py)) freeAround++;
+    }
+    return -8 * dOpp + 2 * min(dOwn, 2) + freeAround;
+}
+
+void orderMoves(const State& s, vector<Move>& moves) {
+    vector<pair<int, Move>> keyed;
+    keyed.reserve(moves.size());
+    for (const auto& m : moves) keyed.push_back({ moveOrderKey(s, m), m });
+    stable_sort(keyed.begin(), keyed.end(),
+                [](const pair<int, Move>& a, const pair<int, Move>& b) { return a.first > b.first; });
+    for (size_t k = 0; k < moves.size(); k++) moves[k] = keyed[k].second;
+}
+
+bool sameMove(const Move& a, const Move& b) {
+    return a.moveX == b.moveX && a.moveY == b.moveY && a.removeX == b.removeX && a.removeY == b.removeY;
+}
+
+// A move of the side to move: a step its pawn can take and a barrier on a cell
+// that is empty after the step.
+bool isLegalFullMove(const State& s, const Move& m) {
+    int px, py;
+    getCurrentPlayerPos(s, px, py);
+    return isLegitMove(s, px, py, m.moveX, m.moveY) && inBounds(m.removeX, m.removeY) &&
+           !(m.removeX == m.moveX && m.removeY == m.moveY) &&
+           (s.board[m.removeX][m.removeY] == EMPTY || (m.removeX == px && m.removeY == py));
+}
+
+// Searches m first if it is in the list (previous iteration's or the TT's best move).
+void moveToFront(vector<Move>& moves, const Move& m) {
+    for (size_t k = 0; k < moves.size(); k++) {
+        if (sameMove(moves[k], m)) {
+            rotate(moves.begin(), moves.begin() + k, moves.begin() + k + 1);
+            return;
+        }
+    }
+}
+
+//==================================================
+// Transposition table
+//==================================================
+// Lossy, shared by all threads without locks, like EvalCache: a slot is
+// (key ^ data, data) in two relaxed atomics. data packs
+// value (32 bits) | depth (6) | bound (2) | generation (8) | best move (4 x 4).
+// Buckets of two slots: the first keeps the deepest entry, the second
+// takes whatever the first refuses.
+// Positions repeat a lot: every order of the same barriers reaches the same
+// board. Entries stay valid from one search to the next (a game reuses the
+// previous move's tree). Keys are salted with ttFingerprint, so values found
+// with another evaluator or other search flags never match; newSearch()
+// bumps the generation, which drops every entry in O(1) (the benches start
+// each search cold). Zone searches, whose values rest on fewer barriers, key
+// their entries apart. Decisive values carry the remaining depth (eval's
+// WIN_SCORE + depth), so they are only reused at the depth they were stored with.
+//
+// --tt-file: the slots live in a file that every process naming it maps
+// (mmap, MAP_SHARED). Results outlive the process and are shared between
+// concurrent ones with the same lock-free updates as between threads: a torn
+// write fails the check and reads as a miss. The header pins the slot layout;
+// the salt keeps builds with another eval, network or flags apart, so they
+// can share a file without reading each other's entries. The generation of
+// a file table stays 0: newSearch() cannot make it cold, so --bench and
+// --idbench, which time cold searches, refuse --tt-file.
+static_assert(N < 15, "TT entries pack coordinates in 4 bits");
+static_assert(atomic<uint64_t>::is_always_lock_free, "TT slots shared through a file need lock-free atomics");
+
+const uint32_t TT_FILE_VERSION = 1; // bump when TTSlot or the data packing changes
+const uint32_t EVAL_VERSION = 1;    // bump when eval or the search changes what a stored value means
+
+enum TTBound { TT_EXACT = 0, TT_LOWER = 1, TT_UPPER = 2 }; // lower: value >= stored
+
+struct TTEntry {
+    int value;
+    int depth;
+    TTBound bound;
+    bool hasMove;
+    Move move;
+};
+
+struct TTSlot {
+    atomic<uint64_t> check{0}; // key ^ data
+    atomic<uint64_t> data{0};
+};
+
+struct TTFileHeader {
+    char magic[4];         // "M3TT"
+    uint32_t version;      // TT_FILE_VERSION
+    uint32_t boardSize;
+    uint32_t log2Entries;
+    uint8_t reserved[48];  // slots start on a cache line
+};
+static_assert(sizeof(TTFileHeader) == 64, "TT file header is one cache line");
+
+struct TranspositionTable {
+    TTSlot* slots = nullptr;
+    size_t mask = 0;
+    atomic<uint64_t> generation{0};
+    string file;            // mapped file, empty for a table in memory
+
+    ~TranspositionTable() { unmap(); }
+
+    void resize(int log2Entries) {
+        unmap();
+        owned.reset(new TTSlot[(size_t)1 << log2Entries]);
+        slots = owned.get();
+        mask = ((size_t)1 << log2Entries) - 1;
+    }
+
+    // Maps 'path', creating it with 2^log2Entries slots (1..30) if it does not
+    // exist (an existing file keeps its size). Fails if the file is a table of
+    // another layout or board size; a file this call created is removed again
+    // if it could not be sized or written.
+    bool attach(const string& path, int log2Entries) {
+#ifdef _WIN32
+        (void)log2Entries;
+        cout << "--tt-file " << path << ": needs mmap, not available in this build" << endl;
+        return false;
+#else
+        if (log2Entries < 1 || log2Entries > 30) {
+            cout << "--tt-file " << path << ": log2 entries must be 1..30, not " << log2Entries << endl;
+            return false;
+        }
+        // One process at a time creates or checks the header. The file we
+        // locked may meanwhile have been unlinked by a failed creation (or
+        // replaced): then open the path again rather than fill an orphan.
+        int fd;
+        struct stat st;
+        for (;;) {
+            fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+            if (fd < 0) {
+                cout << "cannot open " << path << endl;
+                return false;
+            }
+            if (flock(fd, LOCK_EX) != 0) {
+                cout << "cannot lock " << path << " (" << strerror(errno) << ")" << endl;
+                ::close(fd);
+                return false;
+            }
+            struct stat named;
+            if (fstat(fd, &st) != 0) st.st_nlink = 0;
+            if (st.st_nlink > 0 && stat(path.c_str(), &named) == 0 &&
+                named.st_dev == st.st_dev && named.st_ino == st.st_ino) break;
+            flock(fd, LOCK_UN);
+            ::close(fd);
+        }
+        TTFileHeader header{};
+        bool ok = true;
+        if (st.st_size == 0) {
+            memcpy(header.magic, "M3TT", 4);
+            header.version = TT_FILE_VERSION;
+            header.boardSize = N;
+            header.log2Entries = (uint32_t)log2Entries;
+            ok = ftruncate(fd, (off_t)(sizeof(header) + (sizeof(TTSlot) << log2Entries))) == 0 &&
+                 pwrite(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header);
+            if (!ok) {
+                // Unlinked while still locked: a process waiting for the lock
+                // finds the inode gone and creates the file anew
+                cout << "cannot create " << path << endl;
+                unlink(path.c_str());
+            }
+        } else {
+            ok = pread(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) &&
+                 memcmp(header.magic, "M3TT", 4) == 0 && header.version == TT_FILE_VERSION &&
+                 header.boardSize == (uint32_t)N && header.log2Entries >= 1 && header.log2Entries <= 30 &&
+                 st.st_size == (off_t)(sizeof(header) + (sizeof(TTSlot) << header.log2Entries));
+            if (!ok) cout << path << ": not a table of this version and board size, remove it or use another file" << endl;
+        }
+        size_t bytes = sizeof(header) + (sizeof(TTSlot) << header.log2Entries);
+        void* base = ok ? mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+        flock(fd, LOCK_UN);
+        ::close(fd);
+        if (base == MAP_FAILED) {
+            if (ok) cout << "cannot map " << path << endl;
+            return false;
+        }
+        unmap();
+        owned.reset();
+        mapped = base;
+        mappedBytes = bytes;
+        slots = (TTSlot*)((char*)base + sizeof(header));
+        mask = ((size_t)1 << header.log2Entries) - 1;
+        generation = 0;
+        file = path;
+        return true;
+#endif
+    }
+
+    void newSearch() {
+        if (file.empty()) generation.store((generation.load(memory_order_relaxed) + 1) & 0xFF, memory_order_relaxed);
+    }
+
+    bool probe(uint64_t key, TTEntry& e) const {
+        const TTSlot* bucket = &slots[key & mask & ~(size_t)1];
+        for (int k = 0; k < 2; k++) {
+            uint64_t data = bucket[k].data.load(memory_order_relaxed);
+            if ((bucket[k].check.load(memory_order_relaxed) ^ data) != key ||
+                (data >> 40 & 0xFF) != generation.load(memory_order_relaxed)) continue;
+            e.value = (int)(int32_t)(uint32_t)data;
+            e.depth = (int)(data >> 32 & 0x3F);
+            e.bound = (TTBound)(data >> 38 & 3);
+            uint64_t m = data >> 48;
+            e.hasMove = m != 0xFFFF;
+            e.move = { (int)(m & 0xF), (int)(m >> 4 & 0xF), (int)(m >> 8 & 0xF), (int)(m >> 12 & 0xF) };
+            return true;
+        }
+        return false;
+    }
+
+    void store(uint64_t key, int value, int depth, TTBound bound, const Move* best) {
+        uint64_t m = best ? (uint64_t)(best->moveX | best->moveY << 4 | best->removeX << 8 | best->removeY << 12)
+                          : 0xFFFF;
+        uint64_t gen = generation.load(memory_order_relaxed);
+        uint64_t data = (uint32_t)(int32_t)value | (uint64_t)min(depth, 63) << 32 | (uint64_t)bound << 38 |
+                        gen << 40 | m << 48;
+        TTSlot* bucket = &slots[key & mask & ~(size_t)1];
+        uint64_t old = bucket[0].data.load(memory_order_relaxed);
+        bool oldKey = (bucket[0].check.load(memory_order_relaxed) ^ old) == key;
+        TTSlot& slot = (oldKey || (old >> 40 & 0xFF) != gen || (int)(old >> 32 & 0x3F) <= depth) ? bucket[0] : bucket[1];
+        slot.data.store(data, memory_order_relaxed);
+        slot.check.store(key ^ data, memory_order_relaxed);
+    }
+
+private:
+    unique_ptr<TTSlot[]> owned;
+    void* mapped = nullptr;
+    size_t mappedBytes = 0;
+
+    void unmap() {
+#ifndef _WIN32
+        if (mapped) munmap(mapped, mappedBytes);
+#endif
+        mapped = nullptr;
+        file.clear();
+    }
+};
+
+TranspositionTable tt;
+bool ttEnabled = false; // per SearchOptions.tt, set by prepareSearch
+uint64_t ttSalt = 0;    // ttFingerprint of the current options, set by prepareSearch
+
+// Everything besides the position that a stored value depends on: the code
+// (EVAL_VERSION), the eval weights, the network when it is used and the flags
+// that change values.
+uint64_t ttFingerprint(const SearchOptions& opt) {
+    const EvalWeights& w = *opt.weights;
+    int64_t flags[] = {
+        EVAL_VERSION, N, opt.zoneRadius, opt.collapseDead && !opt.nnue, opt.orderMoves,
+        opt.lmr ? opt.lmrFullMoves : -1, opt.futility ? opt.futilityMargin : -1,
+        opt.extensions ? opt.extensionBudget : -1, opt.quiescence ? opt.quiescencePlies : -1,
+        opt.extensions || opt.quiescence ? opt.lowMobilitySteps : -1,
+        opt.probCut ? llround(opt.probCutSigmas * 1000) : -1,
+        w.phaseBarriers, opt.nnue ? (int64_t)network.fingerprint : -1,
+    };
+    uint64_t h = hashBytes(flags, sizeof(flags));
+    h = hashBytes(w.opening, sizeof(w.opening), h);
+    return hashBytes(w.late, sizeof(w.late), h);
+}
+
+uint64_t ttKey(const State& s, const SearchOptions& opt) {
+    return s.hash ^ ttSalt ^ (s.isMaxTurn ? ZOBRIST.maxTurn : 0) ^ (opt.barriers == BARRIERS_ZONE ? ZOBRIST.zone : 0);
+}
+
+//==================================================
+// Time control (iterative deepening)
+//==================================================
+// When a deadline is set, the search polls the clock every 4096 nodes and
+// unwinds as soon as it passes; the interrupted iteration is discarded.
+// Per thread, so --analyze can run timed searches on every core.
+thread_local bool searchTimed = false;
+thread_local bool searchAborted = false;
+thread_local chrono::steady_clock::time_point searchDeadline;
+
+bool outOfTime() {
+    if (searchTimed && (counters.nodes & 4095) == 0 && chrono::steady_clock::now() >= searchDeadline)
+        searchAborted = true;
+    return searchAborted;
+}
+
+//==================================================
+// Forced moves: extensions and quiescence
+//==================================================
+// A pawn with only one or two steps left is one barrier away from being
+// trapped, so a fixed depth can stop right before the decisive reply.
+bool lowMobility(const State& s, bool forAI, const SearchOptions& opt) {
+    return countMovesForPlayer(s, forAI) < opt.lowMobilitySteps;
+}
+
+// Depth for a child: depth - 1, or depth again (extension) when the side to
+// move there is nearly trapped and the line still has budget left. Its few
+// steps keep the extended node narrow.
+int childDepth(const State& child, int depth, const SearchOptions& opt, int& extensionsLeft) {
+    if (opt.extensions && extensionsLeft > 0 && lowMobility(child, child.isMaxTurn, opt)) {
+        extensionsLeft--;
+        counters.extended++;
+        return depth;
+    }
+    return depth - 1;
+}
+
+// Threat moves: every step, with barriers only next to the opponent's pawn
+// (the ones that take away its steps). A step with no such barrier keeps one
+// barrier as far from the mover as possible, so escapes are still searched.
+vector<Move> generateThreatMoves(const State& s) {
+    vector<Move> res;
+    int ox = s.isMaxTurn ? s.huX : s.aiX;
+    int oy = s.isMaxTurn ? s.huY : s.aiY;
+
+    for (auto p : getLegalStepMoves(s)) {
+        int mx = p.first, my = p.second;
+        State after = s;
+        applyStepMove(after, mx, my);
+
+        size_t first = res.size();
+        for (int k = 0; k < 8; k++) {
+            int bx = ox + dx[k];
+            int by = oy + dy[k];
+            if (inBounds(bx, by) && after.board[bx][by] == EMPTY) res.push_back({mx, my, bx, by});
+        }
+        if (res.size() > first) continue;
+
+        int bestDist = -1;
+        Move quiet{};
+        for (int i = 0; i < N; i++) {
+            for (int j = 0; j < N; j++) {
+                int dist = max(abs(i - mx), abs(j - my));
+                if (after.board[i][j] == EMPTY && dist > bestDist) {
+                    bestDist = dist;
+                    quiet = {mx, my, i, j};
+                }
+            }
+        }
+        if (bestDist >= 0) res.push_back(quiet);
+    }
+    return res;
+}
+
+// Horizon search, like a capture-only quiescence search: quiet positions get
+// the static eval. If the side to move can trap the opponent (opponent low on
+// steps) it may also stand pat on that eval; if the side to move is itself
+// nearly trapped it has to find an escape, so there is no stand-pat.
+// Only threat moves are searched, for at most pliesLeft plies.
+int quiesce(const State& s, int alpha, int beta, const SearchOptions& opt, int pliesLeft) {
+    counters.nodes++;
+    if (outOfTime()) return 0;
+    if (hasNoMoves(s)) return eval(s, 0);
+
+    bool maximize = s.isMaxTurn;
+    bool threatened = lowMobility(s, maximize, opt);
+    bool threatening = lowMobility(s, !maximize, opt);
+    int standPat = eval(s, 0);
+    if (pliesLeft == 0 || (!threatened && !threatening)) return standPat;
+
+    int best = maximize ? -2000000000 : 2000000000;
+    if (!threatened) {
+        best = standPat;
+        if (maximize) alpha = max(alpha, best);
+        else          beta  = min(beta, best);
+        if (beta <= alpha) return best;
+    }
+
+    auto moves = generateThreatMoves(s);
+    counters.expanded++;
+    counters.quiescent++;
+    counters.generated += (long long)moves.size();
+
+    ChildMaker children(s);
+    for (const auto& m : moves) {
+        int val = quiesce(children.apply(m), alpha, beta, opt, pliesLeft - 1);
+        if (searchAborted) return 0;
+        if (maximize) {
+            best = max(best, val);
+            alpha = max(alpha, val);
+        } else {
+            best = min(best, val);
+            beta = min(beta, val);
+        }
+        if (beta <= alpha) break;
+    }
+    return best;
+}
+
+//==================================================
+// ProbCut
+//==================================================
+// The eval is smooth enough that a search PROBCUT_REDUCTION plies shallower
+// predicts the deep score linearly: deep ~ a * shallow + b, with residual
+// standard deviation sigma. Fitted offline with
+//     ./game2 --probcut-dump [positions] [file]   (shallow/deep score pairs)
+//     ./game2 --probcut-fit [file]                (prints this table)
+const int PROBCUT_REDUCTION = 2;
+
+struct ProbCutFit {
+    int deepDepth;
+    double a, b, sigma;
+};
+
+const ProbCutFit PROBCUT_FITS[] = {
+    { 2, 0.6157, -553.4, 1610.9 }, // 235 pairs, r = 0.732 (shallow = static eval)
+    { 3, 0.7952, -164.7, 1492.2 }, // 213 pairs, r = 0.917
+};
+
+// Fit for a node of the given depth (deeper nodes use the deepest fit)
+const ProbCutFit* probCutFit(int depth) {
+    const ProbCutFit* fit = nullptr;
+    for (const auto& f : PROBCUT_FITS)
+        if (f.deepDepth <= depth) fit = &f;
+    return fit;
+}
+
+//==================================================
+// FIX 4: Minimax now passes 'depth' to eval
+//==================================================
+// pvNode: reached through the first move at every level above (with plain
+// alpha-beta this is the line searched with the widest window). LMR and
+// futility only touch non-PV nodes. extensionsLeft: forced-move extensions
+// still allowed on this line (see childDepth).
+int minimax(const State& s, int depth, int alpha, int beta, const SearchOptions& opt, bool pvNode,
+            int extensionsLeft) {
+    if (depth == 0 && opt.quiescence && !hasNoMoves(s)) return quiesce(s, alpha, beta, opt, opt.quiescencePlies);
+
+    counters.nodes++;
+    if (outOfTime()) return 0;
     if (depth == 0 || hasNoMoves(s)) {
         return eval(s, depth); // Passing depth parameter
     }
 
-    auto moves = generateAllMoves(s);
+    // Transposition table: a deep enough entry answers the node (at a PV node
+    // only an exact one, its value must be exact); its move is searched first.
+    int alphaIn = alpha, betaIn = beta;
+    TTEntry entry{};
+    bool ttHit = ttEnabled && tt.probe(ttKey(s, opt), entry);
+    if (ttHit && entry.depth >= depth && (abs(entry.value) <= DECISIVE_SCORE || entry.depth == depth)) {
+        if (entry.bound == TT_EXACT || (!pvNode && entry.bound == TT_LOWER && entry.value >= beta) ||
+            (!pvNode && entry.bound == TT_UPPER && entry.value <= alpha)) {
+            counters.ttCutoffs++;
+            return entry.value;
+        }
+    }
+
+    // ProbCut: a null-window shallow search against the bound shifted through
+    // the fit. If even the shallow score is sigmas beyond the window, the deep
+    // search would almost surely fail the same way. Scores are MAX-relative,
+    // so the same two tests work at MAX and MIN nodes.
+    const ProbCutFit* fit = (opt.probCut && !pvNode) ? probCutFit(depth) : nullptr;
+    if (fit) {
+        int shallowDepth = depth - PROBCUT_REDUCTION;
+        double margin = opt.probCutSigmas * fit->sigma;
+        if (beta < DECISIVE_SCORE) {
+            double bound = ceil((beta + margin - fit->b) / fit->a);
+            if (bound < DECISIVE_SCORE) {
+                int v = minimax(s, shallowDepth, (int)bound - 1, (int)bound, opt, false, 0);
+                if (searchAborted) return 0;
+                if (v >= bound) {
+                    counters.probCuts++;
+                    return beta;
+                }
+            }
+        }
+        if (alpha > -DECISIVE_SCORE) {
+            double bound = floor((alpha - margin - fit->b) / fit->a);
+            if (bound > -DECISIVE_SCORE) {
+                int v = minimax(s, shallowDepth, (int)bound, (int)bound + 1, opt, false, 0);
+                if (searchAborted) return 0;
+                if (v <= bound) {
+                    counters.probCuts++;
+                    return alpha;
+                }
+            }
+        }
+    }
+
+    auto moves = generateAllMoves(s, opt);
+    counters.expanded++;
+    counters.generated += (long long)moves.size();
     if (moves.empty()) return eval(s, depth);
+    if (opt.orderMoves) orderMoves(s, moves);
+    if (ttHit && entry.hasMove) moveToFront(moves, entry.move);
+
+    bool maximize = s.isMaxTurn;
+
+    // Futility: one ply above the horizon every child is a static eval. If this
+    // position's eval plus a margin still cannot reach the window, only moves
+    // that end the game (opponent left without a step) can matter.
+    int futilityBound = 0;
+    bool futile = false;
+    if (opt.futility && depth == 1 && !pvNode) {
+        int standPat = eval(s, depth);
+        futilityBound = maximize ? standPat + opt.futilityMargin : standPat - opt.futilityMargin;
+        futile = maximize ? futilityBound <= alpha : futilityBound >= beta;
+    }
 
-    if (s.isMaxTurn) {
-        int best = -2000000000; // Start lower than LOSE_SCORE
+    int best = maximize ? -2000000000 : 2000000000; // beyond LOSE_SCORE / WIN_SCORE
+    int bestIndex = -1;
 
-        for (const auto& m : moves) {
-            State child = applyMove(s, m);
-            int val = minimax(child, depth - 1, alpha, beta);
+    ChildMaker children(s);
+    for (size_t k = 0; k < moves.size(); k++) {
+        State child = children.apply(moves[k]);
 
-            best = max(best, val);
-            alpha = max(alpha, val);
-            if (beta <= alpha) break;
+        // Forcing children are not static evals when extensions or quiescence are on
+        bool forcing = (opt.extensions || opt.quiescence) &&
+                       (lowMobility(child, true, opt) || lowMobility(child, false, opt));
+        if (futile && !hasNoMoves(child) && !forcing) {
+            counters.futile++;
+            continue;
         }
-        return best;
-    } 
-    else {
-        int best = 2000000000; // Start higher than WIN_SCORE
 
-        for (const auto& m : moves) {
-            State child = applyMove(s, m);
-            int val = minimax(child, depth - 1, alpha, beta);
+        int childExtensions = extensionsLeft;
+        int next = childDepth(child, depth, opt, childExtensions);
+
+        int val;
+        if (opt.lmr && next == depth - 1 && depth >= 2 && !pvNode && (int)k >= opt.lmrFullMoves) {
+            // Late move: one ply shallower first, full depth only if it beats the bound
+            counters.reduced++;
+            val = minimax(child, depth - 2, alpha, beta, opt, false, childExtensions);
+            if (maximize ? val > alpha : val < beta) {
+                counters.lmrResearches++;
+                val = minimax(child, depth - 1, alpha, beta, opt, false, childExtensions);
+            }
+        } else {
+            val = minimax(child, next, alpha, beta, opt, pvNode && k == 0, childExtensions);
+        }
+        if (searchAborted) return 0;
 
-            best = min(best, val);
-            beta = min(beta, val);
-            if (beta <= alpha) break;
+        if (maximize ? val > best : val < best) {
+            best = val;
+            bestIndex = (int)k;
         }
-        return best;
+        if (maximize) alpha = max(alpha, val);
+        else          beta = min(beta, val);
+        if (beta <= alpha) break;
+    }
+
+    // Everything pruned as futile: report the optimistic bound (still outside the window)
+    if (futile) best = maximize ? max(best, futilityBound) : min(best, futilityBound);
+
+    if (ttEnabled && !searchAborted) {
+        TTBound bound = best <= alphaIn ? TT_UPPER : best >= betaIn ? TT_LOWER : TT_EXACT;
+        tt.store(ttKey(s, opt), best, depth, bound, bestIndex >= 0 ? &moves[bestIndex] : nullptr);
     }
+    return best;
 }
 
-Move findBestMove(const State& s, int depth) {
-    auto moves = generateAllMoves(s);
-    Move best{};
-    int bestVal = -2000000000; // Start with a very low value
+// Root search for the side to move (MAX picks the highest value, MIN the lowest;
+// the GUI only calls it for MAX, self-play for both sides). 'first' (optional)
+// is searched before the other moves, e.g. the previous iteration's best move.
+Move searchRoot(const State& s, int depth, const SearchOptions& opt, int& bestVal, const Move* first = nullptr) {
+    auto moves = generateAllMoves(s, opt);
+    counters.nodes++;
+    counters.expanded++;
+    counters.generated += (long long)moves.size();
+    if (opt.orderMoves) orderMoves(s, moves);
+    if (first) moveToFront(moves, *first);
+
+    bool maximize = s.isMaxTurn;
+    Move best = moves.empty() ? Move{} : moves[0];
+    bestVal = maximize ? -2000000000 : 2000000000;
 
     int alpha = -2000000000;
     int beta  =  2000000000;
 
-    for (const auto& m : moves) {
-        State child = applyMove(s, m);
-        int val = minimax(child, depth - 1, alpha, beta);
+    ChildMaker children(s);
+    for (size_t k = 0; k < moves.size(); k++) {
+        State child = children.apply(moves[k]);
+        int extensionsLeft = opt.extensionBudget;
+        int next = childDepth(child, depth, opt, extensionsLeft);
+        int val = minimax(child, next, alpha, beta, opt, k == 0, extensionsLeft);
+        if (searchAborted) break;
 
-        if (val > bestVal) {
+        if (maximize ? val > bestVal : val < bestVal) {
             bestVal = val;
-            best = m;
+            best = moves[k];
         }
-        alpha = max(alpha, val);
+        if (maximize) alpha = max(alpha, val);
+        else          beta  = min(beta, val);
+    }
+    return best;
+}
+
+// searchRoot plus the zone-mode verification
+Move searchVerified(const State& s, int depth, const SearchOptions& opt, int& bestVal, const Move* first = nullptr) {
+    Move best = searchRoot(s, depth, opt, bestVal, first);
+
+    // Verified fallback: a forced result found with a reduced barrier set may
+    // rest on a pruned defence (or a pruned escape), so confirm it with all barriers.
+    if (opt.barriers == BARRIERS_ZONE && abs(bestVal) > DECISIVE_SCORE && !searchAborted) {
+        SearchOptions full = opt;
+        full.barriers = BARRIERS_ALL;
+        counters.researches++;
+        best = searchRoot(s, depth, full, bestVal, first);
     }
     return best;
 }
 
+//==================================================
+// Multi-PV root search
+//==================================================
+// The opt.multiPv best root moves with exact values, in one pass over the
+// root moves rather than one search per line: a move only has to beat the
+// K-th best value so far, so that value bounds the root window (alpha for
+// MAX, beta for MIN) where searchRoot uses the best one. A value inside the
+// window is exact; one outside it is only a bound, but then the move is not
+// among the best K. K = 1 searches exactly like searchRoot. The first K
+// moves are PV nodes. Lines past the root move are read back from the
+// transposition table, so they need opt.tt.
+struct RootLine {
+    Move move;
+    int value;        // from MAX's point of view
+    vector<Move> pv;  // starts with move
+};
+
+// The table's best moves from s on, at most 'length' plies.
+vector<Move> ttPrincipalVariation(const State& from, int length, const SearchOptions& opt) {
+    vector<Move> pv;
+    State s = from;
+    TTEntry e;
+    while ((int)pv.size() < length && ttEnabled && tt.probe(ttKey(s, opt), e) && e.hasMove &&
+           isLegalFullMove(s, e.move)) {
+        pv.push_back(e.move);
+        s = applyMove(s, e.move);
+    }
+    return pv;
+}
+
+vector<RootLine> searchLines(const State& s, int depth, const SearchOptions& opt, const Move* first = nullptr) {
+    auto moves = generateAllMoves(s, opt);
+    counters.nodes++;
+    counters.expanded++;
+    counters.generated += (long long)moves.size();
+    if (opt.orderMoves) orderMoves(s, moves);
+    if (first) moveToFront(moves, *first);
+
+    bool maximize = s.isMaxTurn;
+    size_t lineCount = (size_t)max(1, opt.multiPv);
+    vector<RootLine> lines; // best first
+
+    ChildMaker children(s);
+    for (size_t k = 0; k < moves.size(); k++) {
+        int alpha = -2000000000;
+        int beta  =  2000000000;
+        if (lines.size() == lineCount) (maximize ? alpha : beta) = lines.back().value;
+
+        State child = children.apply(moves[k]);
+        int extensionsLeft = opt.extensionBudget;
+        int next = childDepth(child, depth, opt, extensionsLeft);
+        int val = minimax(child, next, alpha, beta, opt, k < lineCount, extensionsLeft);
+        if (searchAborted) break;
+        if (maximize ? val <= alpha : val >= beta) continue; // bound only: not among the best
+
+        RootLine line{ moves[k], val, { moves[k] } };
+        vector<Move> rest = ttPrincipalVariation(child, next, opt); // before later moves overwrite it
+        line.pv.insert(line.pv.end(), rest.begin(), rest.end());
+        auto at = find_if(lines.begin(), lines.end(),
+                          [&](const RootLine& l) { return maximize ? val > l.value : val < l.value; });
+        lines.insert(at, line);
+        if (lines.size() > lineCount) lines.pop_back();
+    }
+    return lines;
+}
+
+// searchLines plus the zone-mode verification of searchVerified
+vector<RootLine> searchLinesVerified(const State& s, int depth, const SearchOptions& opt, const Move* first = nullptr) {
+    vector<RootLine> lines = searchLines(s, depth, opt, first);
+    bool decisive = any_of(lines.begin(), lines.end(), [](const RootLine& l) { return abs(l.value) > DECISIVE_SCORE; });
+    if (opt.barriers == BARRIERS_ZONE && decisive && !searchAborted) {
+        SearchOptions full = opt;
+        full.barriers = BARRIERS_ALL;
+        counters.researches++;
+        lines = searchLines(s, depth, full, first);
+    }
+    return lines;
+}
+
+//==================================================
+// MCTS (alternative engine)
+//==================================================
+// PUCT over the same State / generateAllMoves rules:
+//  - priors: softmax of moveOrderKey, so the ~300 moves of a node are not
+//    all tried once before the tree can grow deeper
+//  - rollouts: random steps, barrier next to the opponent half the time;
+//    optionally cut after mctsRolloutPlies and scored with eval
+//  - nodes live in one pre-allocated pool, the children of a node contiguous
+//  - tree parallel: every thread walks the shared tree; a visit is counted
+//    on the way down (virtual loss) and the reward added on the way up,
+//    so threads spread over different lines
+// Rewards are win probabilities for the side that played the node's move.
+const double MCTS_EVAL_SCALE = 5000.0;   // eval -> win probability (logistic)
+const double MCTS_PRIOR_TEMPERATURE = 4.0;
+const int MCTS_REWARD_UNIT = 1000;       // rewards are summed in thousandths
+const int MCTS_EXPAND_VISITS = 8;       // a leaf gets children once visited this often
+const int MAX_ROLLOUT_PLIES = 2 * N * N; // every ply blocks a cell, so games end well before
+
+struct MctsNode {
+    Move move{};
+    float prior = 0;
+    int firstChild = -1;
+    int childCount = 0;
+    atomic<int> state{0};        // 0 leaf, 1 being expanded, 2 expanded, 3 leaf for good (pool full)
+    atomic<int> visits{0};       // includes visits still in flight
+    atomic<long long> reward{0}; // in 1/MCTS_REWARD_UNIT
+};
+
+struct MctsTree {
+    unique_ptr<MctsNode[]> pool;
+    int capacity;
+    atomic<int> used{1};         // node 0 is the root
+    atomic<long long> playouts{0};
+    atomic<long long> cacheHits{0}, cacheMisses{0}; // workers' eval cache counters, added once at the end
+
+    explicit MctsTree(int capacity) : pool(new MctsNode[capacity]), capacity(capacity) {}
+};
+
+// Children of a leaf, allocated in one block. Returns false if the pool is full.
+bool expandNode(MctsTree& tree, MctsNode& node, const State& s, const SearchOptions& opt) {
+    auto moves = generateAllMoves(s, opt);
+    int first = tree.used.fetch_add((int)moves.size());
+    if (moves.empty() || first + (int)moves.size() > tree.capacity) return false;
+
+    int maxKey = -1000000;
+    for (const auto& m : moves) maxKey = max(maxKey, moveOrderKey(s, m));
+    double total = 0;
+    for (size_t k = 0; k < moves.size(); k++) {
+        MctsNode& child = tree.pool[first + k];
+        child.move = moves[k];
+        child.prior = (float)exp((moveOrderKey(s, moves[k]) - maxKey) / MCTS_PRIOR_TEMPERATURE);
+        total += child.prior;
+    }
+    for (size_t k = 0; k < moves.size(); k++) tree.pool[first + k].prior /= (float)total;
+
+    node.firstChild = first;
+    node.childCount = (int)moves.size();
+    return true;
+}
+
+int selectChild(const MctsTree& tree, const MctsNode& node, double c) {
+    int parentVisits = node.visits.load(memory_order_relaxed);
+    double parentQ = parentVisits > 0
+        ? (double)node.reward.load(memory_order_relaxed) / MCTS_REWARD_UNIT / parentVisits : 0.5;
+    double fpu = 1.0 - parentQ;  // unvisited child: as good as this node is for its mover
+    double sqrtN = sqrt((double)max(1, parentVisits));
+
+    int best = node.firstChild;
+    double bestScore = -1e18;
+    for (int k = 0; k < node.childCount; k++) {
+        const MctsNode& child = tree.pool[node.firstChild + k];
+        int n = child.visits.load(memory_order_relaxed);
+        double q = n > 0 ? (double)child.reward.load(memory_order_relaxed) / MCTS_REWARD_UNIT / n : fpu;
+        double score = q + c * child.prior * sqrtN / (1 + n);
+        if (score > bestScore) {
+            bestScore = score;
+            best = node.firstChild + k;
+        }
+    }
+    return best;
+}
+
+// Probability that MAX wins the playout from s.
+double rollout(const State& start, const SearchOptions& opt, mt19937& rng) {
+    State s = start;
+    for (int ply = 0; ply < MAX_ROLLOUT_PLIES; ply++) {
+        auto steps = getLegalStepMoves(s);
+        if (steps.empty()) return s.isMaxTurn ? 0.0 : 1.0;
+        if (opt.mctsRolloutPlies > 0 && ply >= opt.mctsRolloutPlies)
+            return 1.0 / (1.0 + exp(-eval(s, 0) / MCTS_EVAL_SCALE));
+
+        auto p = steps[rng() % steps.size()];
+        applyStepMove(s, p.first, p.second);
+
+        int ox = s.isMaxTurn ? s.huX : s.aiX;
+        int oy = s.isMaxTurn ? s.huY : s.aiY;
+        int cells[N * N][2];
+        int count = 0;
+        if (rng() & 1) {
+            for (int k = 0; k < 8; k++) {
+                int bx = ox + dx[k], by = oy + dy[k];
+                if (inBounds(bx, by) && s.board[bx][by] == EMPTY) { cells[count][0] = bx; cells[count][1] = by; count++; }
+            }
+        }
+        if (count == 0) {
+            for (int i = 0; i < N; i++)
+                for (int j = 0; j < N; j++)
+                    if (s.board[i][j] == EMPTY) { cells[count][0] = i; cells[count][1] = j; count++; }
+        }
+        if (count > 0) {
+            int pick = rng() % count;
+            placeBarrier(s, cells[pick][0], cells[pick][1]);
+        }
+        s.isMaxTurn = !s.isMaxTurn;
+    }
+    return 0.5;
+}
+
+void mctsWorker(MctsTree& tree, const State& root, const SearchOptions& opt,
+                chrono::steady_clock::time_point deadline, unsigned seed) {
+    mt19937 rng(seed);
+    vector<int> path;
+    vector<bool> maxMoved; // side that played each node's move
+
+    while (chrono::steady_clock::now() < deadline) {
+        path.assign(1, 0);
+        maxMoved.assign(1, !root.isMaxTurn);
+        State s = root;
+        tree.pool[0].visits.fetch_add(1, memory_order_relaxed);
+
+        // Selection down to a leaf, counting each visit on the way (virtual loss)
+        double result = -1;
+        for (;;) {
+            MctsNode& node = tree.pool[path.back()];
+            if (hasNoMoves(s)) {
+                result = s.isMaxTurn ? 0.0 : 1.0;
+                break;
+            }
+            int expected = 0;
+            if (node.state.load(memory_order_acquire) == 0 &&
+                node.state.compare_exchange_strong(expected, 1, memory_order_acq_rel)) {
+                // Expand after a few visits; a full pool leaves the node a leaf for good
+                bool due = node.visits.load(memory_order_relaxed) >= MCTS_EXPAND_VISITS;
+                if (due && expandNode(tree, node, s, opt)) {
+                    node.state.store(2, memory_order_release);
+                } else {
+                    node.state.store(due ? 3 : 0, memory_order_release);
+                    break;
+                }
+            }
+            if (node.state.load(memory_order_acquire) != 2) break; // leaf, or another thread is expanding it
+
+            int next = selectChild(tree, node, opt.mctsExploration);
+            tree.pool[next].visits.fetch_add(1, memory_order_relaxed);
+            maxMoved.push_back(s.isMaxTurn);
+            s = applyMove(s, tree.pool[next].move);
+            path.push_back(next);
+        }
+
+        if (result < 0) result = rollout(s, opt, rng);
+        tree.playouts.fetch_add(1, memory_order_relaxed);
+
+        for (size_t k = 0; k < path.size(); k++) {
+            double r = maxMoved[k] ? result : 1.0 - result;
+            tree.pool[path[k]].reward.fetch_add((long long)(r * MCTS_REWARD_UNIT), memory_order_relaxed);
+        }
+    }
+    tree.cacheHits.fetch_add(counters.cacheHits, memory_order_relaxed); // a fresh thread: its own counts only
+    tree.cacheMisses.fetch_add(counters.cacheMisses, memory_order_relaxed);
+}
+
+Move findBestMoveMcts(const State& s, const SearchOptions& opt) {
+    MctsTree tree(opt.mctsPoolNodes);
+    MctsNode& root = tree.pool[0];
+    if (!expandNode(tree, root, s, opt)) {
+        SearchOptions all;
+        return generateAllMoves(s, all)[0];
+    }
+    root.state.store(2);
+
+    int threadCount = opt.mctsThreads > 0 ? opt.mctsThreads : max(1, (int)thread::hardware_concurrency());
+    auto deadline = chrono::steady_clock::now() + chrono::milliseconds(opt.mctsBudgetMs);
+    vector<thread> workers;
+    for (int t = 0; t < threadCount; t++)
+        workers.emplace_back(mctsWorker, ref(tree), cref(s), cref(opt), deadline, 12345u + t);
+    for (auto& w : workers) w.join();
+
+    // Most visited move
+    int best = root.firstChild;
+    for (int k = 0; k < root.childCount; k++)
+        if (tree.pool[root.firstChild + k].visits > tree.pool[best].visits) best = root.firstChild + k;
+
+    counters.nodes += min(tree.used.load(), tree.capacity);
+    counters.playouts += tree.playouts;
+    counters.cacheHits += tree.cacheHits;
+    counters.cacheMisses += tree.cacheMisses;
+    return tree.pool[best].move;
+}
+
+// Points eval at the evaluator and cache the options ask for, and sets up the
+// transposition table. Both are kept between searches, only resized on
+// demand (a --tt-file table is mapped by parseSearchFlags and kept).
+// Only writes what changes, so threads searching with the same options
+// (the --tune-eval games) never race on these globals.
+void prepareSearch(const SearchOptions& opt) {
+    const NnueNetwork* net = opt.nnue ? &network : nullptr;
+    if (evalNetwork != net) evalNetwork = net;
+    if (evalCacheEnabled != opt.evalCache) evalCacheEnabled = opt.evalCache;
+    if (opt.evalCache && (!evalCache.entries || evalCache.mask + 1 != ((size_t)1 << opt.evalCacheLog2)))
+        evalCache.resize(opt.evalCacheLog2);
+    if (evalWeights != opt.weights) {
+        evalWeights = opt.weights;
+        if (evalCacheEnabled) evalCache.clear(); // cached scores are for the old weights
+    }
+    if (ttEnabled != opt.tt) ttEnabled = opt.tt;
+    if (!opt.tt) return;
+    if (opt.ttFile.empty() && (!tt.slots || !tt.file.empty() || tt.mask + 1 != ((size_t)1 << opt.ttLog2)))
+        tt.resize(opt.ttLog2);
+    uint64_t salt = ttFingerprint(opt);
+    if (ttSalt != salt) ttSalt = salt;
+}
+
+// Engine entry point: alpha-beta to 'depth', or MCTS for opt.mctsBudgetMs.
+Move findBestMove(const State& s, int depth, const SearchOptions& opt = searchOptions) {
+    prepareSearch(opt);
+    if (opt.engine == ENGINE_MCTS) return findBestMoveMcts(s, opt);
+
+    // Already searched at least this deep (earlier in the game, in an earlier
+    // game or, with --tt-file, by another process): no search at all.
+    TTEntry e;
+    if (ttEnabled && tt.probe(ttKey(s, opt), e) && e.bound == TT_EXACT && e.hasMove && e.depth >= depth &&
+        (abs(e.value) <= DECISIVE_SCORE || e.depth == depth) && isLegalFullMove(s, e.move)) {
+        counters.ttCutoffs++;
+        return e.move;
+    }
+    int bestVal;
+    Move best = searchVerified(s, depth, opt, bestVal);
+    if (ttEnabled && !hasNoMoves(s)) tt.store(ttKey(s, opt), bestVal, depth, TT_EXACT, &best);
+    return best;
+}
+
+// Iterative deepening within budgetMs; returns the best move of the deepest
+// completed iteration and stores that depth in depthReached.
+Move findBestMoveTimed(const State& s, int budgetMs, const SearchOptions& opt, int& depthReached) {
+    prepareSearch(opt);
+    searchTimed = true;
+    searchAborted = false;
+    searchDeadline = chrono::steady_clock::now() + chrono::milliseconds(budgetMs);
+
+    Move best{};
+    depthReached = 0;
+    for (int depth = 1; depth <= N * N; depth++) {
+        int bestVal;
+        Move m = searchVerified(s, depth, opt, bestVal, depthReached > 0 ? &best : nullptr);
+        if (searchAborted) break;
+        best = m;
+        depthReached = depth;
+        if (abs(bestVal) > DECISIVE_SCORE) break; // forced result, deeper search cannot change it
+    }
+    if (depthReached == 0) {
+        SearchOptions all;
+        best = generateAllMoves(s, all)[0]; // budget too small even for depth 1
+    }
+    searchTimed = false;
+    searchAborted = false;
+    return best;
+}
+
+// Multi-PV entry point (alpha-beta): the best opt.multiPv lines at 'depth'.
+vector<RootLine> findBestLines(const State& s, int depth, const SearchOptions& opt = searchOptions) {
+    prepareSearch(opt);
+    return searchLinesVerified(s, depth, opt);
+}
+
 
 //==================================================
 // Initialize Game
 //==================================================
-void initializeGame(State& s) {
+// Any position: pawns, side to move and blocked cells. Returns false if a
+// pawn is off the board, the pawns share a cell or a blocked cell is taken.
+bool setupPosition(State& s, int aiX, int aiY, int huX, int huY, bool maxToMove,
+                   const vector<pair<int,int>>& blocked = {}) {
+    if (!inBounds(aiX, aiY) || !inBounds(huX, huY) || (aiX == huX && aiY == huY)) return false;
     for (int i = 0; i < N; i++)
         for (int j = 0; j < N; j++)
             s.board[i][j] = EMPTY;
 
-    s.aiX = 0;   s.aiY = 3;
-    s.huX = 6;   s.huY = 3;
+    s.aiX = aiX;   s.aiY = aiY;
+    s.huX = huX;   s.huY = huY;
 
     s.board[s.aiX][s.aiY] = AI_PAWN;
     s.board[s.huX][s.huY] = HU_PAWN;
 
-    s.isMaxTurn = false;
+    s.isMaxTurn = maxToMove;
+    s.barriers = 0;
+    memset(s.blockedMask, 0, sizeof(s.blockedMask));
+    s.hash = ZOBRIST.cell[s.aiX][s.aiY][1] ^ ZOBRIST.cell[s.huX][s.huY][2];
+    nnueRefresh(s);
+    for (auto [x, y] : blocked)
+        if (!placeBarrier(s, x, y)) return false;
+    refreshDistances(s);
+    return true;
+}
+
+void initializeGame(State& s) {
+    setupPosition(s, 0, 3, 6, 3, false); // human starts
 }
 
+//==================================================
+// GAME RECORDS (.m3g)
+//==================================================
+// Compact text record written by every front end (m2, m3, treeV/tree.cpp)
+// and read by --analyze. One block per game, any number of games per file:
+//
+//   start 7 ai 0,3 hu 6,3 tomove hu [blocked x,y ...]
+//   moves 5,3/1,3 1,3/5,3 ...      (per ply: step target / barrier cell)
+//   result ai                      (ai, hu, or * when unfinished)
+//
+// --analyze writes the same format with a {note} after each move and
+// '#' comment lines; readers skip both.
+const char* const GAME_RECORD_FILE = "games.m3g";
+
+struct GameRecord {
+    State start;
+    vector<Move> moves;
+    vector<string> notes; // per move (written as {note}); may be shorter than moves
+    string result = "*";
+};
+
+// The side to move has no moves -> it lost.
+string recordResult(const State& final) {
+    if (!hasNoMoves(final)) return "*";
+    return final.isMaxTurn ? "hu" : "ai";
+}
+
+string moveText(const Move& m) {
+    return to_string(m.moveX) + "," + to_string(m.moveY) + "/" + to_string(m.removeX) + "," + to_string(m.removeY);
+}
+
+void writeRecord(ostream& out, const GameRecord& r) {
+    const State& s = r.start;
+    out << "start " << N << " ai " << s.aiX << ',' << s.aiY << " hu " << s.huX << ',' << s.huY
+        << " tomove " << (s.isMaxTurn ? "ai" : "hu");
+    if (s.barriers) {
+        out << " blocked";
+        for (int i = 0; i < N; i++)
+            for (int j = 0; j < N; j++)
+                if (s.board[i][j] == BLOCKED) out << ' ' << i << ',' << j;
+    }
+    out << "\nmoves";
+    for (size_t k = 0; k < r.moves.size(); k++) {
+        out << ' ' << moveText(r.moves[k]);
+        if (k < r.notes.size() && !r.notes[k].empty()) out << " {" << r.notes[k] << '}';
+    }
+    out << "\nresult " << r.result << "\n\n";
+}
+
+bool appendRecord(const string& path, const GameRecord& r) {
+    ofstream out(path, ios::app);
+    if (!out) return false;
+    writeRecord(out, r);
+    return (bool)out;
+}
+
+// Every game of a record file. A game with a bad start line or an illegal
+// move is reported and left out.
+vector<GameRecord> readRecords(const string& path) {
+    vector<GameRecord> games;
+    ifstream in(path);
+    if (!in) {
+        cout << "cannot read " << path << endl;
+        return games;
+    }
+    string line;
+    bool valid = false;
+    State s{};
+    int lineNo = 0;
+    auto fail = [&](const string& why) {
+        cout << path << ":" << lineNo << ": " << why << ", game skipped" << endl;
+        games.pop_back();
+        valid = false;
+    };
+
+    while (getline(in, line)) {
+        lineNo++;
+        istringstream words(line);
+        string key, word;
+        words >> key;
+        if (key == "start") {
+            games.emplace_back();
+            valid = true;
+            int size = 0, ax, ay, hx, hy;
+            string ai, hu, tomove, side;
+            char aiComma = 0, huComma = 0;
+            words >> size >> ai >> ax >> aiComma >> ay >> hu >> hx >> huComma >> hy >> tomove >> side;
+            bool ok = words && aiComma == ',' && huComma == ',';
+            vector<pair<int,int>> blocked;
+            if (ok && words >> word) { // only "blocked x,y ..." may follow, up to the end of the line
+                ok = word == "blocked";
+                while (ok && words >> word) {
+                    int x, y;
+                    char extra;
+                    ok = sscanf(word.c_str(), "%d,%d%c", &x, &y, &extra) == 2;
+                    blocked.push_back({ x, y });
+                }
+            }
+            if (!ok || size != N || ai != "ai" || hu != "hu" || tomove != "tomove" ||
+                (side != "ai" && side != "hu") || !setupPosition(s, ax, ay, hx, hy, side == "ai", blocked)) {
+                fail("bad start line");
+                continue;
+            }
+            games.back().start = s;
+        } else if (key == "moves" && valid) {
+            GameRecord& g = games.back();
+            while (valid && words >> word) {
+                if (word[0] == '{') { // note: up to the closing brace
+                    string note = word.substr(1);
+                    while (note.empty() || note.back() != '}') {
+                        if (!(words >> word)) break;
+                        note += " " + word;
+                    }
+                    if (!note.empty() && note.back() == '}') note.pop_back();
+                    g.notes.resize(g.moves.size());
+                    if (!g.moves.empty()) g.notes.back() = note;
+                    continue;
+                }
+                Move m;
+                if (sscanf(word.c_str(), "%d,%d/%d,%d", &m.moveX, &m.moveY, &m.removeX, &m.removeY) != 4 ||
+                    !isLegalFullMove(s, m)) {
+                    fail("illegal move " + word);
+                    break;
+                }
+                g.moves.push_back(m);
+                s = applyMove(s, m);
+            }
+        } else if (key == "result" && valid) {
+            words >> games.back().result;
+        }
+    }
+    return games;
+}
+
+#ifndef M3_LIBRARY
 //==================================================
 // GUI: Board drawing
 //==================================================
-void drawBoard(sf::RenderWindow& win, const State& s) {
-    sf::RectangleShape cell(sf::Vector2f((float)CELL - 2, (float)CELL - 2));
+// The whole board is one sf::VertexArray (two triangles per cell), so a frame
+// is a single draw call. Positions are built once; drawBoard only recolours
+// the cells whose value differs from what the mesh currently shows.
+struct BoardMesh {
+    sf::VertexArray vertices{ sf::PrimitiveType::Triangles, N * N * 6 };
+    int shown[N][N];
+};
+
+sf::Color cellColor(int v) {
+    if (v == BLOCKED) return sf::Color::Black;
+    if (v == AI_PAWN) return sf::Color::Blue;
+    if (v == HU_PAWN) return sf::Color::Red;
+    return sf::Color(180, 180, 180);
+}
+
+void buildBoardMesh(BoardMesh& mesh) {
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < N; j++) {
+            float x0 = (float)(j * CELL + 2), y0 = (float)(i * CELL + 2);
+            float x1 = x0 + CELL - 2,         y1 = y0 + CELL - 2;
+            sf::Vertex* v = &mesh.vertices[(i * N + j) * 6];
+            v[0].position = { x0, y0 }; v[1].position = { x1, y0 }; v[2].position = { x1, y1 };
+            v[3].position = { x0, y0 }; v[4].position = { x1, y1 }; v[5].position = { x0, y1 };
+            mesh.shown[i][j] = EMPTY;
+            for (int k = 0; k < 6; k++) v[k].color = cellColor(EMPTY);
+        }
+    }
+}
 
+void drawBoard(sf::RenderWindow& win, BoardMesh& mesh, const State& s) {
     for (int i = 0; i < N; i++) {
         for (int j = 0; j < N; j++) {
-            int v = s.board[i][j];
+            if (mesh.shown[i][j] == s.board[i][j]) continue;
+            mesh.shown[i][j] = s.board[i][j];
+            sf::Vertex* v = &mesh.vertices[(i * N + j) * 6];
+            for (int k = 0; k < 6; k++) v[k].color = cellColor(s.board[i][j]);
+        }
+    }
+    win.draw(mesh.vertices);
+}
+#endif
+
+//==================================================
+// HEADLESS TOOLS: self-play and search benchmark
+//==================================================
+// ./game2 --selfplay [games] [depth] <candidate flags>
+//     Candidate options vs the default options. Each game starts from the
+//     initial position plus OPENING_PLIES random plies; every opening is
+//     played twice with the sides swapped.
+// ./game2 --bench [positions] [depth] <candidate flags>
+//     Positions from a default-vs-default game; each is searched with both
+//     configurations. Reports nodes, moves per expanded node, time and
+//     how often the chosen move agrees.
+// ./game2 --idbench [positions] [ms] <candidate flags>
+//     Same positions, iterative deepening with a time budget per move.
+//     Reports the average depth completed, nodes per second and the
+//     LMR / futility counters.
+// Candidate flags (also accepted by the GUI game): --zone [radius], --no-dead-collapse,
+//     --order, --lmr [full moves], --futility [margin], --extend [budget], --quiesce [plies],
+//     --probcut [sigmas], --mcts [ms], --threads n, --rollout-cutoff plies, --nnue [file],
+//     --eval-cache [log2], --tt [log2], --tt-file path [log2], --multipv K
+// ./game2 --probcut-dump [positions] [file] / --probcut-fit [file]
+//     Score pairs for the ProbCut fit, and the least-squares fit itself.
+// ./game2 --nnue-train [games] [epochs] [file]
+//     Self-play data and training for the neural evaluator (written to file).
+//     Experimental: trained networks have not yet beaten the handcrafted eval.
+const int OPENING_PLIES = 2;
+const int MAX_GAME_PLIES = 2 * N * N;
+
+bool parseSearchFlags(int argc, char* argv[], int first, SearchOptions& opt) {
+    for (int i = first; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = (i + 1 < argc && argv[i + 1][0] != '-');
+        if (arg == "--zone") {
+            opt.barriers = BARRIERS_ZONE;
+            if (hasValue) opt.zoneRadius = atoi(argv[++i]);
+        } else if (arg == "--no-dead-collapse") {
+            opt.collapseDead = false;
+        } else if (arg == "--order") {
+            opt.orderMoves = true;
+        } else if (arg == "--lmr") {
+            opt.lmr = opt.orderMoves = true; // reductions only make sense after ordering
+            if (hasValue) opt.lmrFullMoves = atoi(argv[++i]);
+        } else if (arg == "--futility") {
+            opt.futility = true;
+            if (hasValue) opt.futilityMargin = atoi(argv[++i]);
+        } else if (arg == "--extend") {
+            opt.extensions = true;
+            if (hasValue) opt.extensionBudget = atoi(argv[++i]);
+        } else if (arg == "--probcut") {
+            opt.probCut = true;
+            if (hasValue) opt.probCutSigmas = atof(argv[++i]);
+        } else if (arg == "--mcts") {
+            opt.engine = ENGINE_MCTS;
+            if (hasValue) opt.mctsBudgetMs = atoi(argv[++i]);
+        } else if (arg == "--threads" && hasValue) {
+            opt.mctsThreads = atoi(argv[++i]);
+        } else if (arg == "--rollout-cutoff" && hasValue) {
+            opt.mctsRolloutPlies = atoi(argv[++i]);
+        } else if (arg == "--nnue") {
+            // Load before any position exists, so every accumulator is maintained
+            if (!network.loaded && !loadNetwork(hasValue ? argv[++i] : "nnue.bin")) return false;
+            else if (network.loaded && hasValue) i++;
+            opt.nnue = true;
+        } else if (arg == "--eval-cache") {
+            opt.evalCache = true;
+            if (hasValue) opt.evalCacheLog2 = min(30, max(1, atoi(argv[++i])));
+        } else if (arg == "--tt") {
+            opt.tt = true;
+            if (hasValue) opt.ttLog2 = min(30, max(1, atoi(argv[++i])));
+        } else if (arg == "--tt-file" && hasValue) {
+            // Map it now, before any search: an unusable file stops the program
+            opt.tt = true;
+            opt.ttFile = argv[++i];
+            if (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) opt.ttLog2 = min(30, max(1, atoi(argv[++i])));
+            if (tt.file != opt.ttFile && !tt.attach(opt.ttFile, opt.ttLog2)) return false;
+        } else if (arg == "--multipv" && hasValue) {
+            opt.multiPv = max(1, atoi(argv[++i]));
+            opt.tt = true; // the lines are read from the table
+        } else if (arg == "--quiesce") {
+            opt.quiescence = true;
+            if (hasValue) opt.quiescencePlies = atoi(argv[++i]);
+        } else {
+            cout << "Unknown option: " << arg << " (see --help)" << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+Move randomMove(const State& s, mt19937& rng) {
+    SearchOptions all;
+    auto moves = generateAllMoves(s, all);
+    return moves[uniform_int_distribution<size_t>(0, moves.size() - 1)(rng)];
+}
+
+// Plays one game; returns true if MAX wins.
+bool playGame(const State& start, int depth, const SearchOptions& maxOpt, const SearchOptions& minOpt,
+              vector<State>* positions = nullptr, GameRecord* record = nullptr) {
+    State s = start;
+    if (record) record->start = start;
+    for (int ply = 0; ply < MAX_GAME_PLIES && !hasNoMoves(s); ply++) {
+        if (positions) positions->push_back(s);
+        Move m = findBestMove(s, depth, s.isMaxTurn ? maxOpt : minOpt);
+        if (record) record->moves.push_back(m);
+        s = applyMove(s, m);
+    }
+    if (record) record->result = recordResult(s);
+    return !s.isMaxTurn; // side to move has no moves -> it lost
+}
 
-            if (v == EMPTY)
-                cell.setFillColor(sf::Color(180, 180, 180));
-            else if (v == BLOCKED)
-                cell.setFillColor(sf::Color::Black);
-            else if (v == AI_PAWN)
-                cell.setFillColor(sf::Color::Blue);
-            else if (v == HU_PAWN)
-                cell.setFillColor(sf::Color::Red);
+State randomOpening(int seed) {
+    mt19937 rng(seed);
+    State s;
+    initializeGame(s);
+    for (int ply = 0; ply < OPENING_PLIES && !hasNoMoves(s); ply++) s = applyMove(s, randomMove(s, rng));
+    return s;
+}
+
+const char* const SELFPLAY_RECORD_FILE = "selfplay.m3g";
+
+void runSelfPlay(int games, int depth, const SearchOptions& candidate) {
+    SearchOptions baseline;
+    int candidateWins = 0, played = 0;
+    auto start = chrono::steady_clock::now();
+    ofstream(SELFPLAY_RECORD_FILE, ios::trunc); // records of this run only
+
+    for (int g = 0; played < games; g++) {
+        State opening = randomOpening(1000 + g);
+        for (int swap = 0; swap < 2 && played < games; swap++, played++) {
+            bool candidateIsMax = (swap == 0);
+            GameRecord record;
+            bool maxWon = candidateIsMax ? playGame(opening, depth, candidate, baseline, nullptr, &record)
+                                         : playGame(opening, depth, baseline, candidate, nullptr, &record);
+            appendRecord(SELFPLAY_RECORD_FILE, record);
+            bool candidateWon = (maxWon == candidateIsMax);
+            candidateWins += candidateWon;
+            cout << "game " << played + 1 << ": candidate as " << (candidateIsMax ? "MAX" : "MIN")
+                 << (candidateWon ? " won" : " lost") << endl;
+        }
+    }
+
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "candidate " << candidateWins << " / " << played << " ("
+         << 100.0 * candidateWins / played << "%), " << secs << " s, "
+         << counters.researches << " verified re-searches, records in " << SELFPLAY_RECORD_FILE << endl;
+}
+
+void runBench(int positionCount, int depth, const SearchOptions& candidate) {
+    SearchOptions baseline;
+    vector<State> positions;
+    playGame(randomOpening(1), depth, baseline, baseline, &positions);
+    if ((int)positions.size() > positionCount) positions.resize(positionCount);
+
+    struct Totals { long long nodes = 0, expanded = 0, generated = 0, cacheHits = 0, cacheProbes = 0, ttCutoffs = 0;
+                    double ms = 0; };
+    Totals totals[2];
+    int agree = 0;
+
+    for (size_t p = 0; p < positions.size(); p++) {
+        Move chosen[2];
+        for (int c = 0; c < 2; c++) {
+            counters = {};
+            evalCache.clear(); // each search starts cold, so neither warms the other's cache
+            tt.newSearch();
+            auto start = chrono::steady_clock::now();
+            chosen[c] = findBestMove(positions[p], depth, c == 0 ? baseline : candidate);
+            totals[c].ms += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+            totals[c].nodes += counters.nodes;
+            totals[c].expanded += counters.expanded;
+            totals[c].generated += counters.generated;
+            totals[c].cacheHits += counters.cacheHits;
+            totals[c].cacheProbes += counters.cacheHits + counters.cacheMisses;
+            totals[c].ttCutoffs += counters.ttCutoffs;
+        }
+        agree += chosen[0].moveX == chosen[1].moveX && chosen[0].moveY == chosen[1].moveY &&
+                 chosen[0].removeX == chosen[1].removeX && chosen[0].removeY == chosen[1].removeY;
+    }
+
+    const char* names[2] = { "baseline ", "candidate" };
+    for (int c = 0; c < 2; c++) {
+        cout << names[c] << ": " << totals[c].nodes << " nodes, "
+             << (double)totals[c].generated / max(1LL, totals[c].expanded) << " moves/node, "
+             << totals[c].ms << " ms";
+        if (totals[c].cacheProbes)
+            cout << ", eval cache " << 100.0 * totals[c].cacheHits / totals[c].cacheProbes << "% hits";
+        if (totals[c].ttCutoffs) cout << ", " << totals[c].ttCutoffs << " TT cutoffs";
+        cout << endl;
+    }
+    cout << positions.size() << " positions, same move in " << agree << endl;
+}
 
-            cell.setPosition(sf::Vector2f((float)(j * CELL + 2), (float)(i * CELL + 2)));
-            win.draw(cell);
+void runIdBench(int positionCount, int budgetMs, const SearchOptions& candidate) {
+    SearchOptions baseline;
+    vector<State> positions;
+    playGame(randomOpening(1), DEPTH_LIMIT, baseline, baseline, &positions);
+    if ((int)positions.size() > positionCount) positions.resize(positionCount);
+
+    struct Totals { long long nodes = 0, reduced = 0, lmrResearches = 0, futile = 0; int depth = 0; double ms = 0; };
+    Totals totals[2];
+    int agree = 0;
+
+    for (size_t p = 0; p < positions.size(); p++) {
+        Move chosen[2];
+        for (int c = 0; c < 2; c++) {
+            counters = {};
+            evalCache.clear();
+            tt.newSearch();
+            int depthReached;
+            auto start = chrono::steady_clock::now();
+            chosen[c] = findBestMoveTimed(positions[p], budgetMs, c == 0 ? baseline : candidate, depthReached);
+            totals[c].ms += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+            totals[c].depth += depthReached;
+            totals[c].nodes += counters.nodes;
+            totals[c].reduced += counters.reduced;
+            totals[c].lmrResearches += counters.lmrResearches;
+            totals[c].futile += counters.futile;
         }
+        agree += chosen[0].moveX == chosen[1].moveX && chosen[0].moveY == chosen[1].moveY &&
+                 chosen[0].removeX == chosen[1].removeX && chosen[0].removeY == chosen[1].removeY;
     }
+
+    const char* names[2] = { "baseline ", "candidate" };
+    for (int c = 0; c < 2; c++) {
+        cout << names[c] << ": depth " << (double)totals[c].depth / max<size_t>(1, positions.size())
+             << ", " << (long long)(totals[c].nodes / max(1.0, totals[c].ms) * 1000) << " nodes/s, "
+             << totals[c].reduced << " reduced (" << totals[c].lmrResearches << " re-searched), "
+             << totals[c].futile << " futile" << endl;
+    }
+    cout << positions.size() << " positions, " << budgetMs << " ms each, same move in " << agree << endl;
+}
+
+// Positions from games between depth-2 searches plus a few random children
+// of each (search nodes are mostly such positions); for each, the full-window
+// score at every deep depth in PROBCUT_FITS and at that depth minus the reduction.
+void runProbCutDump(int positionCount, const string& path) {
+    SearchOptions opt;
+    mt19937 rng(7);
+    vector<State> positions;
+    for (int g = 0; (int)positions.size() < positionCount; g++) {
+        vector<State> game;
+        playGame(randomOpening(2000 + g), 2, opt, opt, &game);
+        for (size_t p = 0; p < game.size() && (int)positions.size() < positionCount; p++) {
+            positions.push_back(game[p]);
+            for (int c = 0; c < 2 && !hasNoMoves(game[p]); c++)
+                positions.push_back(applyMove(game[p], randomMove(game[p], rng)));
+        }
+    }
+
+    ofstream out(path);
+    out << "# deepDepth shallowScore deepScore" << endl;
+    int written = 0;
+    for (const auto& s : positions) {
+        if (hasNoMoves(s)) continue;
+        for (const auto& f : PROBCUT_FITS) {
+            int shallow = minimax(s, f.deepDepth - PROBCUT_REDUCTION, -2000000000, 2000000000, opt, true, 0);
+            int deep = minimax(s, f.deepDepth, -2000000000, 2000000000, opt, true, 0);
+            if (abs(shallow) > DECISIVE_SCORE || abs(deep) > DECISIVE_SCORE) continue; // not linear
+            out << f.deepDepth << " " << shallow << " " << deep << "\n";
+            written++;
+        }
+    }
+    cout << written << " pairs from " << positions.size() << " positions written to " << path << endl;
+}
+
+void runProbCutFit(const string& path) {
+    ifstream in(path);
+    if (!in) {
+        cout << "Cannot open " << path << endl;
+        return;
+    }
+    struct Sums { double n = 0, x = 0, y = 0, xx = 0, xy = 0, yy = 0; };
+    vector<Sums> sums(N * N + 1);
+    string line;
+    while (getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        int d;
+        double x, y;
+        if (sscanf(line.c_str(), "%d %lf %lf", &d, &x, &y) != 3 || d < 0 || d > N * N) continue;
+        Sums& z = sums[d];
+        z.n++; z.x += x; z.y += y; z.xx += x * x; z.xy += x * y; z.yy += y * y;
+    }
+
+    cout << "const ProbCutFit PROBCUT_FITS[] = {" << endl;
+    for (int d = 0; d <= N * N; d++) {
+        const Sums& z = sums[d];
+        if (z.n < 3) continue;
+        double varX = z.xx - z.x * z.x / z.n;
+        double covXY = z.xy - z.x * z.y / z.n;
+        double a = varX > 0 ? covXY / varX : 1.0;
+        double b = (z.y - a * z.x) / z.n;
+        // residual sum of squares of y - (a x + b)
+        double rss = z.yy - 2 * a * z.xy - 2 * b * z.y + a * a * z.xx + 2 * a * b * z.x + b * b * z.n;
+        double sigma = sqrt(max(0.0, rss / (z.n - 2)));
+        double varY = z.yy - z.y * z.y / z.n;
+        double r = (varX > 0 && varY > 0) ? covXY / sqrt(varX * varY) : 0.0;
+        printf("    { %d, %.4f, %.1f, %.1f }, // %d pairs, r = %.3f\n", d, a, b, sigma, (int)z.n, r);
+    }
+    cout << "};" << endl;
+}
+
+// Training data: games between depth-2 searches (handcrafted eval) from
+// NNUE_OPENING_PLIES random plies. Target per position: the game result and
+// the search score as a win probability, mixed by NNUE_RESULT_WEIGHT, then
+// taken from the side to move's point of view. Every position is also used
+// mirrored left-right (a symmetry of the rules; the colour symmetry is
+// already built into the shared perspective weights). The float network
+// mirrors the integer one (clipped ReLU at 1.0) and is clamped so it quantizes.
+const int NNUE_OPENING_PLIES = 6;
+const float NNUE_RESULT_WEIGHT = 0.5f; // target = w * game result + (1 - w) * search score
+
+struct NnueSample {
+    vector<int> features[2]; // [side to move, other side]
+    float target;            // side to move wins
+};
+
+void addNnueSamples(const State& s, float maxWins, vector<NnueSample>& out) {
+    for (int mirror = 0; mirror < 2; mirror++) {
+        State m = s;
+        if (mirror) {
+            for (int i = 0; i < N; i++)
+                for (int j = 0; j < N; j++) m.board[i][j] = s.board[i][N - 1 - j];
+            m.aiY = N - 1 - s.aiY;
+            m.huY = N - 1 - s.huY;
+        }
+        NnueSample sample;
+        nnueActiveFeatures(m, m.isMaxTurn, sample.features[0]);
+        nnueActiveFeatures(m, !m.isMaxTurn, sample.features[1]);
+        sample.target = m.isMaxTurn ? maxWins : 1.0f - maxWins;
+        out.push_back(sample);
+    }
+}
+
+void runNnueTrain(int games, int epochs, const string& path) {
+    SearchOptions opt;
+    vector<NnueSample> samples;
+    auto start = chrono::steady_clock::now();
+
+    for (int g = 0; g < games; g++) {
+        mt19937 rng(3000 + g);
+        State s;
+        initializeGame(s);
+        for (int ply = 0; ply < NNUE_OPENING_PLIES && !hasNoMoves(s); ply++) s = applyMove(s, randomMove(s, rng));
+
+        vector<pair<State, float>> record;
+        for (int ply = 0; ply < MAX_GAME_PLIES && !hasNoMoves(s); ply++) {
+            int v;
+            Move m = searchVerified(s, 2, opt, v);
+            float teacher = abs(v) > DECISIVE_SCORE ? (v > 0 ? 1.0f : 0.0f)
+                                                    : (float)(1.0 / (1.0 + exp(-v / NNUE_EVAL_SCALE)));
+            record.push_back({ s, teacher });
+            s = applyMove(s, m);
+        }
+        float result = s.isMaxTurn ? 0.0f : 1.0f;
+        for (const auto& [pos, teacher] : record)
+            addNnueSamples(pos, NNUE_RESULT_WEIGHT * result + (1 - NNUE_RESULT_WEIGHT) * teacher, samples);
+    }
+    cout << samples.size() << " samples from " << games << " games in "
+         << chrono::duration<double>(chrono::steady_clock::now() - start).count() << " s" << endl;
+
+    const int H = NNUE_HIDDEN;
+    const float W1_LIMIT = 2.0f;                     // int16 accumulator stays far from overflow
+    const float W2_LIMIT = 127.0f / NNUE_QB;         // int8 output weights
+    mt19937 rng(99);
+    uniform_real_distribution<float> init(-0.1f, 0.1f);
+    vector<float> w1((size_t)NNUE_INPUTS * H), b1(H, 0.5f), w2(2 * H);
+    float b2 = 0.0f;
+    for (auto& w : w1) w = init(rng);
+    for (auto& w : w2) w = init(rng);
+
+    // Positions of one game are correlated; the validation split is by sample
+    // order after a shuffle, which is good enough to watch for overfitting.
+    shuffle(samples.begin(), samples.end(), rng);
+    size_t validation = samples.size() / 10;
+    vector<float> acc(2 * H), h(2 * H);
+
+    auto forward = [&](const NnueSample& x) {
+        float out = b2;
+        for (int half = 0; half < 2; half++) {
+            float* a = &acc[half * H];
+            for (int j = 0; j < H; j++) a[j] = b1[j];
+            for (int f : x.features[half])
+                for (int j = 0; j < H; j++) a[j] += w1[(size_t)f * H + j];
+            for (int j = 0; j < H; j++) {
+                h[half * H + j] = min(max(a[j], 0.0f), 1.0f);
+                out += w2[half * H + j] * h[half * H + j];
+            }
+        }
+        return 1.0f / (1.0f + exp(-out));
+    };
+    auto crossEntropy = [](float p, float t) {
+        p = min(max(p, 1e-6f), 1.0f - 1e-6f);
+        return -(t * log(p) + (1 - t) * log(1 - p));
+    };
+
+    for (int epoch = 0; epoch < epochs; epoch++) {
+        float lr = 0.01f * (1.0f - 0.9f * epoch / max(1, epochs));
+        shuffle(samples.begin() + validation, samples.end(), rng);
+        double trainLoss = 0;
+        for (size_t n = validation; n < samples.size(); n++) {
+            const NnueSample& x = samples[n];
+            float p = forward(x);
+            trainLoss += crossEntropy(p, x.target);
+            float g = p - x.target; // d(cross entropy)/d(logit)
+            for (int half = 0; half < 2; half++) {
+                for (int j = 0; j < H; j++) {
+                    int o = half * H + j;
+                    float gAcc = (acc[o] > 0.0f && acc[o] < 1.0f) ? g * w2[o] : 0.0f;
+                    w2[o] = min(max(w2[o] - lr * g * h[o], -W2_LIMIT), W2_LIMIT);
+                    if (gAcc == 0.0f) continue;
+                    b1[j] -= lr * gAcc;
+                    for (int f : x.features[half]) {
+                        float& w = w1[(size_t)f * H + j];
+                        w = min(max(w - lr * gAcc, -W1_LIMIT), W1_LIMIT);
+                    }
+                }
+            }
+            b2 -= lr * g;
+        }
+        double validationLoss = 0;
+        for (size_t n = 0; n < validation; n++) validationLoss += crossEntropy(forward(samples[n]), samples[n].target);
+        cout << "epoch " << epoch + 1 << ": train " << trainLoss / max<size_t>(1, samples.size() - validation)
+             << ", validation " << validationLoss / max<size_t>(1, validation) << endl;
+    }
+
+    auto quantize = [](float v, float scale, int limit) {
+        return (int)max(-limit, min(limit, (int)lround(v * scale)));
+    };
+    for (int f = 0; f < NNUE_INPUTS; f++)
+        for (int j = 0; j < H; j++) network.w1[f][j] = (int16_t)quantize(w1[(size_t)f * H + j], NNUE_QA, 32767);
+    for (int j = 0; j < H; j++) network.b1[j] = (int16_t)quantize(b1[j], NNUE_QA, 32767);
+    for (int o = 0; o < 2 * H; o++) network.w2[o] = (int8_t)quantize(w2[o], NNUE_QB, 127);
+    network.b2 = quantize(b2, NNUE_QA * NNUE_QB, 1 << 30);
+    network.loaded = true;
+    fingerprintNetwork(network);
+    cout << (saveNetwork(path) ? "network written to " : "cannot write ") << path << endl;
+}
+
+//==================================================
+// Eval tuning (Texel)
+//==================================================
+// Positions from self-play labelled with the game result; the handcrafted
+// weights are fitted to them by logistic regression. sigmoid(K * score)
+// predicts the result, where score is the weighted term sum eval multiplies
+// by 1000. K is fitted first with the current weights and then held fixed,
+// so tuned scores keep the scale the search margins (futility, ProbCut)
+// were set for. Games, term extraction and the fit all run on every core.
+const int TUNE_OPENING_PLIES = 4;
+const int TUNE_MAX_PHASE = 20;     // phase switches tried: 0..TUNE_MAX_PHASE barriers
+const int TUNE_NEWTON_STEPS = 50;
+const int TUNE_MATCH_GAMES = 20;   // tuned vs current weights at depth 2
+
+struct TuneSample {
+    float terms[EVAL_TERMS];       // all five, whatever the phase
+    int barriers;
+    float result;                  // MAX won
+    bool validation;               // every tenth game is held out
+};
+
+// Runs body(begin, end) over [0, n) split across 'threads' threads (0 = all cores).
+template <class Body>
+void parallelFor(size_t n, Body body, int threads = 0) {
+    size_t threadCount = threads > 0 ? threads : max(1u, thread::hardware_concurrency());
+    threadCount = max<size_t>(1, min(threadCount, n));
+    vector<thread> workers;
+    for (size_t t = 0; t < threadCount; t++)
+        workers.emplace_back([&, t] { body(n * t / threadCount, n * (t + 1) / threadCount); });
+    for (auto& w : workers) w.join();
+}
+
+double tuneScore(const TuneSample& x, const double w[EVAL_TERMS]) {
+    double score = 0.0;
+    for (int i = 0; i < EVAL_TERMS; i++) score += w[i] * x.terms[i];
+    return score;
+}
+
+const double* tunePhaseWeights(const EvalWeights& w, const TuneSample& x) {
+    return x.barriers >= w.phaseBarriers ? w.late : w.opening;
+}
+
+// Mean cross entropy of sigmoid(K * score) over the training or validation samples.
+double tuneLoss(const vector<TuneSample>& samples, const EvalWeights& w, double K, bool validation) {
+    mutex lock;
+    double total = 0.0;
+    long long count = 0;
+    parallelFor(samples.size(), [&](size_t begin, size_t end) {
+        double sum = 0.0;
+        long long n = 0;
+        for (size_t i = begin; i < end; i++) {
+            const TuneSample& x = samples[i];
+            if (x.validation != validation) continue;
+            double p = 1.0 / (1.0 + exp(-K * tuneScore(x, tunePhaseWeights(w, x))));
+            p = min(max(p, 1e-9), 1.0 - 1e-9);
+            sum -= x.result * log(p) + (1 - x.result) * log(1 - p);
+            n++;
+        }
+        lock_guard<mutex> guard(lock);
+        total += sum;
+        count += n;
+    });
+    return total / max(1LL, count);
+}
+
+// Newton's method on the logistic loss of the training samples in
+// [minBarriers, maxBarriers], over the terms in 'active'; returns K * weights.
+void tuneFitPhase(const vector<TuneSample>& samples, int minBarriers, int maxBarriers,
+                  const bool active[EVAL_TERMS], double beta[EVAL_TERMS]) {
+    const int T = EVAL_TERMS;
+    for (int i = 0; i < T; i++) beta[i] = 0.0;
+    for (int step = 0; step < TUNE_NEWTON_STEPS; step++) {
+        double grad[T] = {}, hess[T][T] = {};
+        mutex lock;
+        parallelFor(samples.size(), [&](size_t begin, size_t end) {
+            double g[T] = {}, h[T][T] = {};
+            for (size_t n = begin; n < end; n++) {
+                const TuneSample& x = samples[n];
+                if (x.validation || x.barriers < minBarriers || x.barriers > maxBarriers) continue;
+                double p = 1.0 / (1.0 + exp(-tuneScore(x, beta)));
+                for (int i = 0; i < T; i++) {
+                    g[i] += (p - x.result) * x.terms[i];
+                    for (int j = 0; j < T; j++) h[i][j] += p * (1 - p) * x.terms[i] * x.terms[j];
+                }
+            }
+            lock_guard<mutex> guard(lock);
+            for (int i = 0; i < T; i++) {
+                grad[i] += g[i];
+                for (int j = 0; j < T; j++) hess[i][j] += h[i][j];
+            }
+        });
+
+        // Solve hess * delta = grad on the active terms (Gaussian elimination;
+        // the small ridge keeps a term that never varies from blowing up).
+        double a[T][T + 1] = {};
+        int idx[T], m = 0;
+        for (int i = 0; i < T; i++) if (active[i]) idx[m++] = i;
+        for (int r = 0; r < m; r++) {
+            for (int c = 0; c < m; c++) a[r][c] = hess[idx[r]][idx[c]] + (r == c ? 1e-6 : 0.0);
+            a[r][m] = grad[idx[r]];
+        }
+        for (int c = 0; c < m; c++) {
+            int pivot = c;
+            for (int r = c + 1; r < m; r++) if (abs(a[r][c]) > abs(a[pivot][c])) pivot = r;
+            swap(a[c], a[pivot]);
+            for (int r = 0; r < m; r++) {
+                if (r == c) continue;
+                double f = a[r][c] / a[c][c];
+                for (int k = c; k <= m; k++) a[r][k] -= f * a[c][k];
+            }
+        }
+        double change = 0.0;
+        for (int r = 0; r < m; r++) {
+            double delta = a[r][m] / a[r][r];
+            beta[idx[r]] -= delta;
+            change = max(change, abs(delta));
+        }
+        if (change < 1e-7) break;
+    }
+}
+
+bool writeEvalWeights(const EvalWeights& w, const string& path) {
+    ofstream out(path);
+    if (!out) return false;
+    auto row = [&](const double* v) {
+        out << "{ ";
+        for (int i = 0; i < EVAL_TERMS; i++) out << (i ? ", " : "") << fixed << setprecision(4) << v[i];
+        out << " }";
+    };
+    out << "// Generated by ./game2 --tune-eval (see runEvalTune in m3.cpp); rerun it\n"
+           "// rather than editing by hand. Weights of the clamped, normalized eval\n"
+           "// terms a b c d e; eval scales the weighted sum by 1000.\n"
+           "#pragma once\n\n"
+           "const EvalWeights EVAL_WEIGHTS = {\n"
+        << "    " << w.phaseBarriers << ", // phaseBarriers: c and e are used from this many barriers on\n"
+        << "    ";
+    row(w.opening);
+    out << ", // opening\n    ";
+    row(w.late);
+    out << ", // late\n};\n";
+    return (bool)out;
+}
+
+void runEvalTune(int games, int depth, const string& path) {
+    auto start = chrono::steady_clock::now();
+    auto seconds = [&] { return chrono::duration<double>(chrono::steady_clock::now() - start).count(); };
+
+    // 1) Self-play games, one slice of the game indices per core.
+    SearchOptions opt;
+    prepareSearch(opt); // before the threads: they then only read the evaluator globals
+    vector<vector<State>> gamePositions(games);
+    vector<char> maxWon(games);
+    parallelFor(games, [&](size_t begin, size_t end) {
+        for (size_t g = begin; g < end; g++) {
+            mt19937 rng(5000 + g);
+            State s;
+            initializeGame(s);
+            for (int ply = 0; ply < TUNE_OPENING_PLIES && !hasNoMoves(s); ply++) s = applyMove(s, randomMove(s, rng));
+            maxWon[g] = playGame(s, depth, opt, opt, &gamePositions[g]);
+        }
+    });
+    size_t total = 0;
+    for (const auto& p : gamePositions) total += p.size();
+    cout << total << " positions from " << games << " depth-" << depth << " games in " << seconds() << " s" << endl;
+
+    // 2) Terms of every position, as one parallel batch.
+    vector<TuneSample> samples(total);
+    vector<pair<int, int>> origin; // (game, ply) of each sample
+    origin.reserve(total);
+    for (int g = 0; g < games; g++)
+        for (int p = 0; p < (int)gamePositions[g].size(); p++) origin.push_back({ g, p });
+    parallelFor(total, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            const State& s = gamePositions[origin[i].first][origin[i].second];
+            double t[EVAL_TERMS];
+            evalTerms(s, true, t);
+            TuneSample& x = samples[i];
+            for (int k = 0; k < EVAL_TERMS; k++) x.terms[k] = (float)t[k];
+            x.barriers = s.barriers;
+            x.result = maxWon[origin[i].first] ? 1.0f : 0.0f;
+            x.validation = origin[i].first % 10 == 0;
+        }
+    });
+    gamePositions.clear();
+    cout << "terms extracted at " << seconds() << " s" << endl;
+
+    // 3) K for the current weights (golden-section search on the training loss).
+    double lo = 0.01, hi = 10.0;
+    const double ratio = (sqrt(5.0) - 1) / 2;
+    for (int i = 0; i < 40; i++) {
+        double m1 = hi - ratio * (hi - lo), m2 = lo + ratio * (hi - lo);
+        if (tuneLoss(samples, EVAL_WEIGHTS, m1, false) < tuneLoss(samples, EVAL_WEIGHTS, m2, false)) hi = m2;
+        else lo = m1;
+    }
+    double K = (lo + hi) / 2;
+    cout << "K = " << K << ", current weights: train " << tuneLoss(samples, EVAL_WEIGHTS, K, false)
+         << ", validation " << tuneLoss(samples, EVAL_WEIGHTS, K, true) << endl;
+
+    // 4) Weights for every phase switch; keep the best on validation.
+    const bool openingTerms[EVAL_TERMS] = { true, true, false, true, false }; // c, e not computed
+    const bool allTerms[EVAL_TERMS] = { true, true, true, true, true };
+    EvalWeights best = EVAL_WEIGHTS;
+    double bestLoss = 1e9;
+    for (int phase = 0; phase <= TUNE_MAX_PHASE; phase++) {
+        EvalWeights w{};
+        w.phaseBarriers = phase;
+        tuneFitPhase(samples, 0, phase - 1, openingTerms, w.opening);
+        tuneFitPhase(samples, phase, N * N, allTerms, w.late);
+        for (int i = 0; i < EVAL_TERMS; i++) { w.opening[i] /= K; w.late[i] /= K; }
+        double loss = tuneLoss(samples, w, K, true);
+        if (loss < bestLoss) { bestLoss = loss; best = w; }
+    }
+    cout << "tuned (phase switch at " << best.phaseBarriers << " barriers): train " << tuneLoss(samples, best, K, false)
+         << ", validation " << bestLoss << ", " << seconds() << " s" << endl;
+    cout << (writeEvalWeights(best, path) ? "weights written to " : "cannot write ") << path << endl;
+
+    // 5) Tuned against current weights; rebuild to use the new header.
+    SearchOptions tuned;
+    tuned.weights = &best;
+    runSelfPlay(TUNE_MATCH_GAMES, 2, tuned);
+}
+
+//==================================================
+// Game analysis (--analyze)
+//==================================================
+// Every position of every recorded game is one job; the cores take jobs
+// from a shared counter (early positions cost far more than late ones).
+// Per position: the best move and its value, and the value of the played
+// move (its child searched one ply shallower, as searchRoot scores it),
+// both from MAX's point of view. At a fixed depth, or iterative deepening
+// within a time budget per position (timed searches are per thread).
+// A move is flagged "?" when it is at least 'margin' worse for the mover
+// than the best, "??" when it gives up a forced win or walks into a forced
+// loss the best move avoids. With --multipv K the K best moves are searched
+// together (searchLines) and all of them go into the note; a played move
+// among them needs no search of its own.
+struct AnalysisJob {
+    int game, ply;
+    State s;
+    Move played;
+    Move best{};
+    int bestValue = 0, playedValue = 0, depth = 0;
+    vector<RootLine> lines{}; // multi-PV only
+};
+
+int playedMoveValue(const State& s, const Move& m, int depth, const SearchOptions& opt) {
+    State child = applyMove(s, m);
+    if (depth <= 1 || hasNoMoves(child)) return eval(child, depth - 1);
+    int value;
+    searchVerified(child, depth - 1, opt, value);
+    return value;
+}
+
+void analysePosition(AnalysisJob& job, int depth, int budgetMs, const SearchOptions& opt) {
+    auto searchAt = [&](int d) {
+        int bestValue;
+        Move best;
+        vector<RootLine> lines;
+        if (opt.multiPv > 1) {
+            lines = searchLinesVerified(job.s, d, opt);
+            if (searchAborted || lines.empty()) return false;
+            best = lines[0].move;
+            bestValue = lines[0].value;
+        } else {
+            best = searchVerified(job.s, d, opt, bestValue);
+        }
+        auto played = find_if(lines.begin(), lines.end(), [&](const RootLine& l) { return sameMove(l.move, job.played); });
+        int playedValue = sameMove(best, job.played) ? bestValue
+                        : played != lines.end() ? played->value : playedMoveValue(job.s, job.played, d, opt);
+        if (searchAborted) return false;
+        job.lines = move(lines);
+        job.best = best;
+        job.bestValue = bestValue;
+        job.playedValue = playedValue;
+        job.depth = d;
+        return true;
+    };
+    if (budgetMs <= 0) {
+        searchAt(depth);
+        return;
+    }
+    searchTimed = true;
+    searchAborted = false;
+    searchDeadline = chrono::steady_clock::now() + chrono::milliseconds(budgetMs);
+    for (int d = 1; d <= N * N && searchAt(d) && abs(job.bestValue) <= DECISIVE_SCORE; d++) {}
+    searchTimed = false;
+    searchAborted = false;
+    if (job.depth == 0) searchAt(1); // budget too small even for depth 1
+}
+
+// How much worse the played move is for the mover; "?", "??" or "" for the note.
+long long moveLoss(const AnalysisJob& job) {
+    long long diff = (long long)job.bestValue - job.playedValue;
+    return max(0LL, job.s.isMaxTurn ? diff : -diff);
+}
+
+const char* moveMark(const AnalysisJob& job, int margin) {
+    int sign = job.s.isMaxTurn ? 1 : -1;
+    bool bestWins = sign * job.bestValue > DECISIVE_SCORE, playedWins = sign * job.playedValue > DECISIVE_SCORE;
+    bool bestLoses = sign * job.bestValue < -DECISIVE_SCORE, playedLoses = sign * job.playedValue < -DECISIVE_SCORE;
+    if ((bestWins && !playedWins) || (playedLoses && !bestLoses)) return "??";
+    if (moveLoss(job) >= margin) return "?";
+    return "";
+}
+
+void runAnalyze(const vector<string>& paths, int depth, int budgetMs, int margin, const string& outPath,
+                const SearchOptions& opt) {
+    auto start = chrono::steady_clock::now();
+    vector<GameRecord> games;
+    for (const string& path : paths) {
+        vector<GameRecord> file = readRecords(path);
+        games.insert(games.end(), file.begin(), file.end());
+    }
+
+    vector<AnalysisJob> jobs;
+    for (int g = 0; g < (int)games.size(); g++) {
+        State s = games[g].start;
+        for (int ply = 0; ply < (int)games[g].moves.size(); ply++) {
+            jobs.push_back({ g, ply, s, games[g].moves[ply] });
+            s = applyMove(s, games[g].moves[ply]);
+        }
+    }
+
+    prepareSearch(opt); // before the threads: they then only read the evaluator globals
+    int threadCount = opt.mctsThreads > 0 ? opt.mctsThreads : max(1, (int)thread::hardware_concurrency());
+    atomic<size_t> next{0};
+    atomic<long long> cacheHits{0}, cacheProbes{0}; // per-thread counters, summed once per thread
+    parallelFor(threadCount, [&](size_t, size_t) {
+        SearchCounters before = counters;
+        for (size_t i; (i = next++) < jobs.size();) analysePosition(jobs[i], depth, budgetMs, opt);
+        cacheHits += counters.cacheHits - before.cacheHits;
+        cacheProbes += counters.cacheHits + counters.cacheMisses - before.cacheHits - before.cacheMisses;
+    }, threadCount);
+
+    int flagged[2] = {};
+    for (const AnalysisJob& job : jobs) {
+        GameRecord& g = games[job.game];
+        g.notes.resize(g.moves.size());
+        string mark = moveMark(job, margin);
+        string note = to_string(job.playedValue);
+        string best = job.lines.empty() ? " " + moveText(job.best) + " " + to_string(job.bestValue) : "";
+        for (const RootLine& line : job.lines) best += " " + moveText(line.move) + " " + to_string(line.value);
+        if (!mark.empty() || job.lines.size() > 1) note += (mark.empty() ? "" : " " + mark) + " best" + best;
+        if (!mark.empty()) {
+            flagged[mark == "??"]++;
+            cout << "game " << job.game + 1 << " ply " << job.ply + 1 << ": " << moveText(job.played) << " " << mark
+                 << " (" << job.playedValue << "), best " << moveText(job.best) << " (" << job.bestValue << ")" << endl;
+        }
+        g.notes[job.ply] = note;
+    }
+
+    ofstream out(outPath);
+    out << "# m3 analysis: " << (budgetMs > 0 ? to_string(budgetMs) + " ms" : "depth " + to_string(depth))
+        << " per position, margin " << margin << (opt.multiPv > 1 ? ", " + to_string(opt.multiPv) + " lines" : "")
+        << "; {value of the played move for MAX}\n\n";
+    for (const GameRecord& g : games) writeRecord(out, g);
+
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    long long depthSum = 0;
+    for (const AnalysisJob& job : jobs) depthSum += job.depth;
+    cout << games.size() << " games, " << jobs.size() << " positions in " << secs << " s on " << threadCount
+         << " threads (mean depth " << (double)depthSum / max<size_t>(1, jobs.size()) << "), "
+         << flagged[0] << " marked ?, " << flagged[1] << " marked ??" << endl;
+    if (cacheProbes > 0) cout << "eval cache " << 100.0 * cacheHits / cacheProbes << "% hits" << endl;
+    cout << (out ? "annotated records written to " : "cannot write ") << outPath << endl;
 }
 
+//==================================================
+// C API (libm3, see m3.h)
+//==================================================
+#include "m3.h"
+
+static_assert(M3_BOARD_SIZE == N, "m3.h describes a different board size");
+static_assert(sizeof(m3_position) == N * N + 1 && sizeof(m3_move) == 4 && sizeof(m3_line) == 8 + 4 * M3_MAX_PV,
+              "m3.h structs must stay packed");
+
+// Board, pawns and every incremental field of State from a packed position.
+// Fails unless each cell code is known and there is exactly one pawn of each side.
+bool unpackPosition(const m3_position& p, State& s) {
+    int pawns[3] = {};
+    s.barriers = 0;
+    s.hash = 0;
+    memset(s.blockedMask, 0, sizeof(s.blockedMask));
+    for (int x = 0; x < N; x++) {
+        for (int y = 0; y < N; y++) {
+            int code = p.cells[x * N + y];
+            switch (code) {
+            case M3_EMPTY:   s.board[x][y] = EMPTY; break;
+            case M3_AI_PAWN: s.board[x][y] = AI_PAWN; s.aiX = x; s.aiY = y; break;
+            case M3_HU_PAWN: s.board[x][y] = HU_PAWN; s.huX = x; s.huY = y; break;
+            case M3_BLOCKED:
+                s.board[x][y] = BLOCKED;
+                s.barriers++;
+                s.hash ^= ZOBRIST.cell[x][y][0];
+                for (int k = 0; k < 8; k++)
+                    if (inBounds(x + dx[k], y + dy[k])) s.blockedMask[x + dx[k]][y + dy[k]] |= 1 << (7 - k);
+                break;
+            default: return false;
+            }
+            if (code == M3_AI_PAWN || code == M3_HU_PAWN) pawns[code]++;
+        }
+    }
+    if (pawns[M3_AI_PAWN] != 1 || pawns[M3_HU_PAWN] != 1) return false;
+    s.isMaxTurn = p.maxToMove != 0;
+    s.hash ^= ZOBRIST.cell[s.aiX][s.aiY][1] ^ ZOBRIST.cell[s.huX][s.huY][2];
+    refreshDistances(s);
+    nnueRefresh(s);
+    return true;
+}
+
+extern "C" {
+
+M3_API int m3_abi_version(void) { return M3_ABI_VERSION; }
+M3_API int m3_board_size(void) { return N; }
+
+M3_API int m3_configure(const char* flags) {
+    vector<string> words;
+    string word;
+    for (const char* c = flags ? flags : ""; ; c++) {
+        if (*c && *c != ' ' && *c != '\t') { word += *c; continue; }
+        if (!word.empty()) words.push_back(word);
+        word.clear();
+        if (!*c) break;
+    }
+    vector<char*> argv = { (char*)"m3" };
+    for (auto& w : words) argv.push_back(&w[0]);
+
+    SearchOptions opt;
+    if (!parseSearchFlags((int)argv.size(), argv.data(), 1, opt) || opt.engine == ENGINE_MCTS) return -1;
+    searchOptions = opt;
+    return 0;
+}
+
+M3_API size_t m3_evaluate(const m3_position* positions, size_t count, int32_t* scores, int threads) {
+    prepareSearch(searchOptions); // before the threads: they then only read the evaluator globals
+    atomic<size_t> invalid{0};
+    parallelFor(count, [&](size_t begin, size_t end) {
+        State s;
+        for (size_t i = begin; i < end; i++) {
+            if (!unpackPosition(positions[i], s)) { scores[i] = M3_INVALID_SCORE; invalid++; continue; }
+            scores[i] = eval(s, 0);
+        }
+    }, threads);
+    return invalid;
+}
+
+M3_API size_t m3_search(const m3_position* positions, size_t count, int depth,
+                        m3_move* moves, int32_t* scores, int threads) {
+    prepareSearch(searchOptions);
+    atomic<size_t> invalid{0};
+    parallelFor(count, [&](size_t begin, size_t end) {
+        State s;
+        for (size_t i = begin; i < end; i++) {
+            moves[i] = { M3_NO_MOVE, M3_NO_MOVE, M3_NO_MOVE, M3_NO_MOVE };
+            if (depth < 1 || !unpackPosition(positions[i], s)) { scores[i] = M3_INVALID_SCORE; invalid++; continue; }
+            if (hasNoMoves(s)) { scores[i] = eval(s, depth); continue; }
+            int value;
+            Move m = searchVerified(s, depth, searchOptions, value);
+            moves[i] = { (uint8_t)m.moveX, (uint8_t)m.moveY, (uint8_t)m.removeX, (uint8_t)m.removeY };
+            scores[i] = value;
+        }
+    }, threads);
+    return invalid;
+}
+
+M3_API size_t m3_search_lines(const m3_position* positions, size_t count, int depth, int lines,
+                              m3_line* out, int threads) {
+    if (lines < 1 || depth < 1) return count; // out may have no room at all: leave it untouched
+    SearchOptions opt = searchOptions;
+    opt.multiPv = lines;
+    opt.tt = true; // the lines are read from the table
+    prepareSearch(opt);
+    atomic<size_t> invalid{0};
+    parallelFor(count, [&](size_t begin, size_t end) {
+        State s;
+        for (size_t i = begin; i < end; i++) {
+            m3_line* row = out + i * opt.multiPv;
+            for (int k = 0; k < opt.multiPv; k++) row[k] = {};
+            if (!unpackPosition(positions[i], s)) { row[0].score = M3_INVALID_SCORE; invalid++; continue; }
+            if (hasNoMoves(s)) { row[0].score = eval(s, depth); continue; }
+            vector<RootLine> found = searchLinesVerified(s, depth, opt);
+            for (size_t k = 0; k < found.size(); k++) {
+                row[k].score = found[k].value;
+                row[k].pvLength = (uint8_t)min<size_t>(found[k].pv.size(), M3_MAX_PV);
+                for (int j = 0; j < row[k].pvLength; j++) {
+                    const Move& m = found[k].pv[j];
+                    row[k].pv[j] = { (uint8_t)m.moveX, (uint8_t)m.moveY, (uint8_t)m.removeX, (uint8_t)m.removeY };
+                }
+            }
+        }
+    }, threads);
+    return invalid;
+}
+
+} // extern "C"
+
+#ifndef M3_LIBRARY
 //==================================================
 // MAIN
 //==================================================
-int main() {
+void printUsage() {
+    cout << "./game2 [search flags]                      GUI game against the AI\n"
+            "./game2 --selfplay [games] [depth] [search flags]\n"
+            "./game2 --bench [positions] [depth] [search flags]\n"
+            "./game2 --idbench [positions] [ms] [search flags]\n"
+            "./game2 --analyze file.m3g [more.m3g ...] [--depth d | --ms t] [--margin m] [--out file] [search flags]\n"
+            "./game2 --tune-eval [games] [depth] [file]\n"
+            "./game2 --nnue-train [games] [epochs] [file]   (experimental, see --nnue)\n"
+            "./game2 --probcut-dump [positions] [file] / --probcut-fit [file]\n"
+            "depth and ms are at least 1\n"
+            "search flags:\n"
+            "  --zone [radius] --no-dead-collapse --order --lmr [full moves] --futility [margin]\n"
+            "  --extend [budget] --quiesce [plies] --probcut [sigmas]\n"
+            "  --mcts [ms] --threads n --rollout-cutoff plies   (MCTS engine instead of alpha-beta)\n"
+            "  --nnue [file]   EXPERIMENTAL neural evaluator (default nnue.bin); so far weaker than\n"
+            "                  the handcrafted eval at equal depth and at equal time\n"
+            "  --eval-cache [log2] --tt [log2] --tt-file path [log2] --multipv K" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    string mode = argc >= 2 ? argv[1] : "";
+    if (mode == "--help" || mode == "-h") {
+        printUsage();
+        return 0;
+    }
+    if (mode == "--selfplay" || mode == "--bench" || mode == "--idbench") {
+        int first = 2;
+        int count = (first < argc && argv[first][0] != '-') ? atoi(argv[first++]) : (mode == "--selfplay" ? 20 : 10);
+        int depthOrMs = (first < argc && argv[first][0] != '-') ? atoi(argv[first++])
+                                                                : (mode == "--idbench" ? 1000 : DEPTH_LIMIT);
+        if (depthOrMs < 1) {
+            cout << mode << ": " << (mode == "--idbench" ? "ms" : "depth") << " must be at least 1 (see --help)" << endl;
+            return 1;
+        }
+        SearchOptions candidate;
+        if (!parseSearchFlags(argc, argv, first, candidate)) return 1;
+        if (mode != "--selfplay" && !candidate.ttFile.empty()) {
+            cout << mode << " times cold searches; a --tt-file table stays warm, use --tt instead" << endl;
+            return 1;
+        }
+        if (mode == "--selfplay")   runSelfPlay(count, depthOrMs, candidate);
+        else if (mode == "--bench") runBench(count, depthOrMs, candidate);
+        else                        runIdBench(count, depthOrMs, candidate);
+        return 0;
+    }
+    if (mode == "--probcut-dump") {
+        int count = (argc >= 3) ? atoi(argv[2]) : 200;
+        runProbCutDump(count, argc >= 4 ? argv[3] : "probcut_pairs.txt");
+        return 0;
+    }
+    if (mode == "--nnue-train") {
+        int games = (argc >= 3) ? atoi(argv[2]) : 200;
+        int epochs = (argc >= 4) ? atoi(argv[3]) : 10;
+        runNnueTrain(games, epochs, argc >= 5 ? argv[4] : "nnue.bin");
+        return 0;
+    }
+    if (mode == "--analyze") {
+        // ./game2 --analyze games.m3g [more.m3g ...] [--depth d | --ms t] [--margin m] [--out file] [search flags]
+        vector<string> paths;
+        int first = 2;
+        while (first < argc && argv[first][0] != '-') paths.push_back(argv[first++]);
+        int depth = DEPTH_LIMIT, budgetMs = 0, margin = 1000;
+        string outPath = "analysis.m3g";
+        vector<char*> flags = { argv[0] };
+        for (int i = first; i < argc; i++) {
+            string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--depth" && hasValue)       depth = atoi(argv[++i]);
+            else if (arg == "--ms" && hasValue)     budgetMs = atoi(argv[++i]);
+            else if (arg == "--margin" && hasValue) margin = atoi(argv[++i]);
+            else if (arg == "--out" && hasValue)    outPath = argv[++i];
+            else flags.push_back(argv[i]);
+        }
+        if (depth < 1) {
+            cout << "--analyze: --depth must be at least 1 (see --help)" << endl;
+            return 1;
+        }
+        SearchOptions opt;
+        if (paths.empty() || !parseSearchFlags((int)flags.size(), flags.data(), 1, opt)) return 1;
+        if (opt.engine == ENGINE_MCTS) {
+            cout << "--analyze needs the alpha-beta search (it compares move values)" << endl;
+            return 1;
+        }
+        runAnalyze(paths, depth, budgetMs, margin, outPath, opt);
+        return 0;
+    }
+    if (mode == "--tune-eval") {
+        int games = (argc >= 3) ? atoi(argv[2]) : 20000;
+        int depth = (argc >= 4) ? atoi(argv[3]) : 1;
+        if (depth < 1) {
+            cout << "--tune-eval: depth must be at least 1 (see --help)" << endl;
+            return 1;
+        }
+        runEvalTune(games, depth, argc >= 5 ? argv[4] : "eval_weights.h");
+        return 0;
+    }
+    if (mode == "--probcut-fit") {
+        runProbCutFit(argc >= 3 ? argv[2] : "probcut_pairs.txt");
+        return 0;
+    }
+    // GUI game: the same flags configure the AI (e.g. ./game2 --zone)
+    if (!parseSearchFlags(argc, argv, 1, searchOptions)) return 1;
+
     sf::RenderWindow window(
         sf::VideoMode({ (unsigned int)(N * CELL),
                         (unsigned int)(N * CELL + UI_HEIGHT) }),
@@ -515,12 +3307,35 @@ int main() {
     State game;
     initializeGame(game);
 
+    GameRecord record;
+    record.start = game;
+    State lastComplete = game; // after the last full move (a close can come between step and barrier)
+    bool recorded = false;     // close and game over can both arrive in one loop pass
+    auto recordGame = [&] {
+        if (recorded || record.moves.empty()) return false;
+        record.result = recordResult(lastComplete); // * while the game is still on
+        recorded = true;
+        return appendRecord(GAME_RECORD_FILE, record);
+    };
+    Move humanMove{};
+
+    BoardMesh boardMesh;
+    buildBoardMesh(boardMesh);
+
     int depthLimit = DEPTH_LIMIT;
     int hStage = 0;
+    bool needsRedraw = true;
 
     while (window.isOpen()) {
-        while (const std::optional<sf::Event> event = window.pollEvent()) {
+        // Waiting for the human: block in waitEvent instead of spinning.
+        // The AI turn and game over need no input, so only poll then.
+        std::optional<sf::Event> event = (needsRedraw || game.isMaxTurn || hasNoMoves(game))
+                                             ? window.pollEvent() : window.waitEvent();
+        for (; event; event = window.pollEvent()) {
+            needsRedraw = true; // clicks, resize, focus: repaint once afterwards
+
             if (event->is<sf::Event::Closed>()) {
+                recordGame();
                 window.close();
             }
 
@@ -546,13 +3361,19 @@ int main() {
                         }
                         if (ok) {
                             applyStepMove(game, gx, gy);
+                            humanMove.moveX = gx;
+                            humanMove.moveY = gy;
                             hStage = 1; 
                         }
                     }
                     else if (hStage == 1) {
                         if (game.board[gx][gy] == EMPTY) {
                             placeBarrier(game, gx, gy);
+                            humanMove.removeX = gx;
+                            humanMove.removeY = gy;
+                            record.moves.push_back(humanMove);
                             game.isMaxTurn = true;
+                            lastComplete = game;
                             hStage = 0;            
                         }
                     }
@@ -562,13 +3383,15 @@ int main() {
 
         if (hasNoMoves(game)) {
             window.clear();
-            drawBoard(window, game);
+            drawBoard(window, boardMesh, game);
             
             std::string msg;
             if (game.isMaxTurn) msg = "Game Over: HUMAN Won!";
             else                msg = "Game Over: AI Won!";
             
             std::cout << msg << std::endl;
+            if (recordGame())
+                std::cout << "Game recorded in " << GAME_RECORD_FILE << std::endl;
             if (font.getInfo().family != "") {
                 infoText.setString(msg);
                 window.draw(infoText);
@@ -585,14 +3408,28 @@ int main() {
                 infoText.setString("AI is thinking...");
             }
             window.clear();
-            drawBoard(window, game);
+            drawBoard(window, boardMesh, game);
             if (font.getInfo().family != "")
                 window.draw(infoText);
             window.display();
             sf::sleep(sf::milliseconds(100));
 
-            Move ai = findBestMove(game, depthLimit);
+            Move ai;
+            if (searchOptions.multiPv > 1 && searchOptions.engine == ENGINE_ALPHABETA) {
+                vector<RootLine> lines = findBestLines(game, depthLimit);
+                for (size_t k = 0; k < lines.size(); k++) {
+                    cout << k + 1 << ". " << lines[k].value << ":";
+                    for (const Move& m : lines[k].pv) cout << " " << moveText(m);
+                    cout << endl;
+                }
+                ai = lines.empty() ? findBestMove(game, depthLimit) : lines[0].move;
+            } else {
+                ai = findBestMove(game, depthLimit);
+            }
             game = applyMove(game, ai);
+            record.moves.push_back(ai);
+            lastComplete = game;
+            needsRedraw = true;
             turns++;
             cout << "Turns: " << turns << endl;
         }
@@ -604,12 +3441,16 @@ int main() {
                 infoText.setString("Your turn: Place a barrier.");
         }
 
-        window.clear();
-        drawBoard(window, game);
-        if (font.getInfo().family != "")
-            window.draw(infoText);
-        window.display();
+        if (needsRedraw) {
+            window.clear();
+            drawBoard(window, boardMesh, game);
+            if (font.getInfo().family != "")
+                window.draw(infoText);
+            window.display();
+            needsRedraw = false;
+        }
     }
 
     return 0;
-}
\ No newline at end of file
+}
+#endif // M3_LIBRARY
@@ -0,0 +1,95 @@
+/*
+ * m3.h: C interface to the m3.cpp engine, built as a shared library
+ * without SFML:
+ *
+ *   g++ -std=c++17 -O2 -pthread -fPIC -shared -fvisibility=hidden -DM3_LIBRARY m3.cpp -o libm3.so
+ *
+ * Positions go in as flat arrays of m3_position; the batch calls fill the
+ * caller's result arrays in place and split the batch across threads.
+ * Structs hold uint8_t fields (and a leading int32_t), laid out so that
+ * there is no padding and the layout is the same from C, C++ and ctypes.
+ * M3_ABI_VERSION changes whenever the layout, a signature or the set of
+ * functions does.
+ */
+#ifndef M3_H
+#define M3_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#define M3_API __declspec(dllexport)
+#else
+#define M3_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define M3_ABI_VERSION 2
+#define M3_BOARD_SIZE  7
+
+/* Cell codes of a packed position */
+#define M3_EMPTY   0
+#define M3_AI_PAWN 1   /* MAX (blue) */
+#define M3_HU_PAWN 2   /* MIN (red) */
+#define M3_BLOCKED 3
+
+#define M3_NO_MOVE       255                  /* m3_move fields when the side to move has no move */
+#define M3_INVALID_SCORE (-2147483647 - 1)    /* score of a position that failed validation */
+#define M3_MAX_PV        16                   /* moves kept per m3_line */
+
+/* cells[x * M3_BOARD_SIZE + y] is board cell (x, y); exactly one AI and one HU pawn */
+typedef struct {
+    uint8_t cells[M3_BOARD_SIZE * M3_BOARD_SIZE];
+    uint8_t maxToMove;  /* 1: MAX (AI) to move, 0: MIN (human) */
+} m3_position;
+
+typedef struct {
+    uint8_t moveX, moveY;      /* pawn destination */
+    uint8_t removeX, removeY;  /* cell blocked after the step */
+} m3_move;
+
+/* One root move with its exact value and principal variation (pv[0] is the root move) */
+typedef struct {
+    int32_t score;
+    uint8_t pvLength;          /* 0: unused line (fewer legal moves than lines) */
+    uint8_t reserved[3];
+    m3_move pv[M3_MAX_PV];
+} m3_line;
+
+M3_API int m3_abi_version(void);
+M3_API int m3_board_size(void);
+
+/* Search options for later calls, in ./game2 flag syntax (e.g. "--order --lmr 6"
+ * or "--nnue nnue.bin"). Not thread-safe with running batches. Returns 0, or
+ * -1 for an unknown flag or --mcts (the batch search is alpha-beta). */
+M3_API int m3_configure(const char* flags);
+
+/* Static eval from MAX's point of view. Returns the number of invalid
+ * positions; their scores are M3_INVALID_SCORE. threads: 0 = all cores. */
+M3_API size_t m3_evaluate(const m3_position* positions, size_t count, int32_t* scores, int threads);
+
+/* Best move and alpha-beta value of each position at 'depth' (at least 1;
+ * with a smaller depth every position is reported invalid). Same return value
+ * and threads as m3_evaluate; moves of invalid positions are M3_NO_MOVE. */
+M3_API size_t m3_search(const m3_position* positions, size_t count, int depth,
+                        m3_move* moves, int32_t* scores, int threads);
+
+/* The 'lines' best moves of each position at 'depth', best first, with exact
+ * values and their principal variations (multi-PV). out holds count * lines
+ * entries, those of position i from out[i * lines]. The positions share one
+ * transposition table (enabled for this call). An invalid position has
+ * M3_INVALID_SCORE in its first line; one without moves has its value there
+ * and pvLength 0. Same return value and threads as m3_evaluate. lines and
+ * depth must be at least 1; otherwise out is not written and count is
+ * returned (every position invalid). */
+M3_API size_t m3_search_lines(const m3_position* positions, size_t count, int depth, int lines,
+                              m3_line* out, int threads);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* M3_H */
@@ -0,0 +1,687 @@
+#include <SFML/Graphics.hpp>
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <optional>
+#include <string>
+#include <fstream>
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <chrono>
+
+using namespace std;
+
+//==================================================
+// EXPLORER CONSTANTS
+//==================================================
+// tree.cpp'nin yazdığı game_data.bin (sürüm 4) için yerel ağaç gezgini.
+// Düğümler çocuk indeksi üzerinden istek üzerine okunur; çizim, yalnızca
+// ekrana düşen ve ayırt edilebilecek kadar büyük düğümleri içeren
+// sf::VertexArray'lerle yapılır (level-of-detail).
+const int WINDOW_W = 1280;
+const int WINDOW_H = 800;
+const int PANEL_W  = 320;       // sol panel: tahta + bilgi
+const int CELL     = 40;        // panel tahtasında hücre boyu
+
+const float LEVEL_PX   = 220.f; // derinlikler arası yatay mesafe (piksel)
+const float TREE_LEFT  = 60.f;  // kökün panel kenarından uzaklığı
+const double SLOT      = 1.0;   // bir yaprağın dünya yüksekliği
+const float NODE_PX    = 8.f;   // düğüm karesi
+const float LOD_MIN_PX = 3.f;   // kardeşler bundan sıksa tek bant olarak çizilir
+const float LABEL_PX   = 16.f;  // skor yazısı için gereken yaprak yüksekliği
+const int   MAX_LABELS = 400;
+
+const uint32_t BIN_LOG_VERSION = 6;
+
+enum Cell { EMPTY = 0, AI_PAWN = 1, HU_PAWN = 2, BLOCKED = -1 };
+
+//==================================================
+// LOG RECORDS (tree.cpp ile aynı düzen)
+//==================================================
+enum NodeType : uint8_t { NODE_ROOT, NODE_MAX, NODE_MIN };
+enum NodeInfo : uint8_t { INFO_NONE, INFO_START, INFO_LEAF, INFO_PRUNED_BETA, INFO_PRUNED_ALPHA, INFO_TRANSPOSITION };
+
+const char* const NODE_TYPE_NAMES[] = { "ROOT", "MAX", "MIN" };
+const char* const NODE_INFO_NAMES[] = { "", "Start", "Leaf", "Pruned (Beta)", "Pruned (Alpha)", "Transposition" };
+
+struct LogNode {
+    int32_t  id;
+    int32_t  parentId;
+    int32_t  score;
+    uint8_t  depth;
+    NodeType type;
+    NodeInfo info;
+    uint8_t  reserved;
+};
+
+//==================================================
+// BINARY LOG READER
+//==================================================
+// Format ayrıntısı tree.cpp'deki "STREAMING TREE LOGGER" açıklamasında.
+// Dosyanın tamamı okunmaz: başlık, tur indeksi, seçilen turun özeti ve
+// çocuk indeksi, sonra yalnızca açılan düğümlerin çocuk kayıtları.
+struct TurnEntry {
+    uint64_t offset;
+    int32_t  turn;
+    int32_t  bestScore;
+    uint32_t nodeCount;
+    uint32_t chunkCount;
+    uint64_t summaryOffset;
+    uint64_t childIndexOffset;
+};
+
+struct ChildGroup {
+    uint32_t start;
+    uint32_t count;
+};
+
+struct LineMove {
+    int8_t moveX, moveY, removeX, removeY;
+    int32_t score;
+};
+
+struct TurnData {
+    TurnEntry entry;
+    vector<int8_t> board;                        // N*N, satır sıralı
+    uint32_t timeUs = 0;
+    vector<uint32_t> depthNodes;                 // derinlik başına düğüm sayısı
+    uint32_t transpositions = 0, savedNodes = 0; // DAG modu (--dag)
+    unordered_map<int32_t, uint32_t> multiplicity;
+    uint32_t multiPv = 1;                        // skoru kesin en iyi kök hamle sayısı (--multipv)
+    vector<vector<LineMove>> lines;              // en iyi multiPv kök hamlesi: hamle + PV'si
+    unordered_map<int32_t, ChildGroup> groups;   // parentId -> çocuk kayıt aralığı
+    vector<uint64_t> chunkOffsets;
+};
+
+class BinaryLog {
+public:
+    int n = 0;
+
+    bool open(const string& path) {
+        in.open(path, ios::binary);
+        if (!in) return false;
+
+        char tag[4];
+        uint32_t version = 0;
+        in.read(tag, 4);
+        version = readU32();
+        n = (int)readU32();
+        chunkNodes = readU32();
+        if (!in || string(tag, 4) != "TLOG") return fail("TLOG başlığı yok");
+        if (version != BIN_LOG_VERSION) return fail("desteklenmeyen sürüm " + to_string(version));
+
+        in.seekg(-16, ios::end);
+        uint64_t indexOffset = readU64();
+        uint32_t turnCount = readU32();
+        in.read(tag, 4);
+        if (!in || string(tag, 4) != "TEND") return fail("dosya yarım (TEND yok)");
+
+        in.seekg((streamoff)indexOffset);
+        turns.resize(turnCount);
+        for (auto& t : turns) {
+            t.offset = readU64();
+            t.turn = readI32();
+            t.bestScore = readI32();
+            t.nodeCount = readU32();
+            t.chunkCount = readU32();
+            t.summaryOffset = readU64();
+            t.childIndexOffset = readU64();
+        }
+        return (bool)in;
+    }
+
+    int turnCount() const { return (int)turns.size(); }
+
+    TurnData loadTurn(int i) {
+        TurnData t;
+        t.entry = turns[i];
+
+        in.seekg((streamoff)(t.entry.offset + 4));
+        t.board.resize(n * n);
+        in.read((char*)t.board.data(), n * n);
+
+        in.seekg((streamoff)t.entry.summaryOffset);
+        t.timeUs = readU32();
+        uint32_t depthCount = readU32();
+        for (uint32_t d = 0; d < depthCount; d++) {
+            t.depthNodes.push_back(readU32());
+            readU32(); readU32(); // cutoffs, generated
+        }
+        for (int moveList = 0; moveList < 2; moveList++) { // rootMoves, pv
+            uint32_t count = readU32();
+            in.seekg(8 * (streamoff)count, ios::cur);
+        }
+        t.transpositions = readU32();
+        t.savedNodes = readU32();
+        uint32_t multCount = readU32();
+        for (uint32_t k = 0; k < multCount; k++) {
+            int32_t id = readI32();
+            t.multiplicity[id] = readU32();
+        }
+        t.multiPv = readU32();
+        uint32_t lineCount = readU32();
+        for (uint32_t k = 0; k < lineCount; k++) {
+            vector<LineMove> line(readU32());
+            for (auto& m : line) {
+                in.read((char*)&m.moveX, 4);
+                m.score = readI32();
+            }
+            t.lines.push_back(move(line));
+        }
+
+        in.seekg((streamoff)t.entry.childIndexOffset);
+        uint32_t groupCount = readU32();
+        t.groups.reserve(groupCount);
+        for (uint32_t g = 0; g < groupCount; g++) {
+            int32_t parentId = readI32();
+            uint32_t start = readU32();
+            uint32_t count = readU32();
+            t.groups[parentId] = { start, count };
+        }
+        t.chunkOffsets.resize(readU32());
+        for (auto& off : t.chunkOffsets) off = readU64();
+        return t;
+    }
+
+    // [start, start+count) kayıtları; aralık birden fazla chunk'a yayılabilir
+    void readRecords(const TurnData& t, uint32_t start, uint32_t count, vector<LogNode>& out) {
+        out.resize(count);
+        uint32_t done = 0;
+        while (done < count) {
+            uint32_t rec = start + done;
+            uint32_t c = rec / chunkNodes;
+            uint32_t inChunk = (c + 1 == t.chunkOffsets.size()) ? t.entry.nodeCount - c * chunkNodes : chunkNodes;
+            uint32_t first = rec - c * chunkNodes;
+            uint32_t take = min(count - done, inChunk - first);
+            readChunkRows(t.chunkOffsets[c] + 4, inChunk, first, take, out.data() + done);
+            done += take;
+        }
+    }
+
+private:
+    ifstream in;
+    uint32_t chunkNodes = 0;
+    vector<TurnEntry> turns;
+    vector<int32_t> column;
+
+    bool fail(const string& msg) {
+        cout << "Hata: game_data.bin okunamadı: " << msg << endl;
+        return false;
+    }
+
+    uint32_t readU32() { uint32_t v = 0; in.read((char*)&v, 4); return v; }
+    int32_t  readI32() { int32_t v = 0; in.read((char*)&v, 4); return v; }
+    uint64_t readU64() { uint64_t v = 0; in.read((char*)&v, 8); return v; }
+
+    // Kolon bazlı chunk: her kolondan yalnızca gereken dilim okunur
+    void readChunkRows(uint64_t base, uint32_t count, uint32_t first, uint32_t take, LogNode* out) {
+        column.resize(take);
+        int32_t LogNode::* intCols[3] = { &LogNode::id, &LogNode::parentId, &LogNode::score };
+        for (int k = 0; k < 3; k++) {
+            in.seekg((streamoff)(base + 4ull * (k * (uint64_t)count + first)));
+            in.read((char*)column.data(), 4ull * take);
+            for (uint32_t j = 0; j < take; j++) out[j].*intCols[k] = column[j];
+        }
+        uint8_t* bytes = (uint8_t*)column.data();
+        for (int k = 0; k < 3; k++) {
+            in.seekg((streamoff)(base + 12ull * count + (uint64_t)k * count + first));
+            in.read((char*)bytes, take);
+            for (uint32_t j = 0; j < take; j++) {
+                if (k == 0) out[j].depth = bytes[j];
+                else if (k == 1) out[j].type = (NodeType)bytes[j];
+                else out[j].info = (NodeInfo)bytes[j];
+            }
+        }
+        for (uint32_t j = 0; j < take; j++) out[j].reserved = 0;
+    }
+};
+
+//==================================================
+// EXPLORER TREE
+//==================================================
+// Yüklenen düğümler tek bir vektörde; bir düğümün çocukları bitişik
+// (firstChild .. firstChild+childCount). Kapatılan dalın çocukları
+// bellekte kalır, yeniden açmak dosyaya gitmez.
+struct ViewNode {
+    LogNode  rec;
+    int32_t  parent;
+    int32_t  firstChild;   // -1: çocuklar henüz okunmadı
+    uint32_t childCount;   // indeksteki çocuk sayısı (okunmamış olsa da)
+    uint32_t leafStart;    // yerleşim: ilk yaprak slotu
+    uint32_t leafSpan;     // yerleşim: kapladığı yaprak slotu
+    bool     expanded;
+};
+
+class ExplorerTree {
+public:
+    vector<ViewNode> nodes;
+
+    void reset(BinaryLog& log, const TurnData& t) {
+        nodes.clear();
+        auto it = t.groups.find(-1);
+        if (it == t.groups.end()) return;
+        log.readRecords(t, it->second.start, 1, buffer);
+        addNode(t, buffer[0], -1);
+        expand(log, t, 0);
+    }
+
+    void expand(BinaryLog& log, const TurnData& t, int i) {
+        if (nodes[i].childCount == 0) return;
+        if (nodes[i].firstChild < 0) {
+            const ChildGroup& g = t.groups.at(nodes[i].rec.id);
+            log.readRecords(t, g.start, g.count, buffer);
+            nodes[i].firstChild = (int32_t)nodes.size();
+            for (const auto& rec : buffer) addNode(t, rec, i);
+        }
+        nodes[i].expanded = true;
+    }
+
+    void toggle(BinaryLog& log, const TurnData& t, int i) {
+        if (nodes[i].expanded) nodes[i].expanded = false;
+        else expand(log, t, i);
+    }
+
+    // Bütün ağacı açar (büyük turlarda milyonlarca düğüm)
+    void expandAll(BinaryLog& log, const TurnData& t) {
+        for (size_t i = 0; i < nodes.size(); i++) expand(log, t, (int)i);
+    }
+
+    void collapseAll() {
+        for (auto& v : nodes) v.expanded = false;
+        if (!nodes.empty()) nodes[0].expanded = true;
+    }
+
+    // Yaprak slotlarını dağıtır: açık olmayan her düğüm bir slot kaplar
+    void layout() {
+        if (nodes.empty()) return;
+        uint32_t next = 0;
+        layoutNode(0, next);
+    }
+
+    bool hasHiddenChildren(const ViewNode& v) const { return v.childCount > 0 && !v.expanded; }
+
+private:
+    vector<LogNode> buffer;
+
+    void addNode(const TurnData& t, const LogNode& rec, int parent) {
+        auto it = t.groups.find(rec.id);
+        nodes.push_back({ rec, parent, -1, it == t.groups.end() ? 0u : it->second.count, 0, 1, false });
+    }
+
+    void layoutNode(int i, uint32_t& next) {
+        ViewNode& v = nodes[i];
+        v.leafStart = next;
+        if (v.expanded && v.childCount > 0) {
+            for (uint32_t c = 0; c < v.childCount; c++) layoutNode(v.firstChild + (int)c, next);
+        } else {
+            next++;
+        }
+        nodes[i].leafSpan = next - nodes[i].leafStart;
+    }
+};
+
+//==================================================
+// TREE RENDERER (LEVEL OF DETAIL)
+//==================================================
+// Kamera yalnızca dikeyde yakınlaşır: derinlik sayısı küçük (DEPTH_LIMIT+1),
+// genişlik milyonlarca yaprak olabilir. Köşe noktaları doğrudan ekran
+// pikselinde üretilir (double -> float), böylece büyük slot numaralarında
+// float hassasiyeti kaybolmaz.
+struct Camera {
+    double centerY = 0;  // dünya koordinatı (slot)
+    double zoom = 1;     // slot başına piksel
+    float  panX = 0;
+};
+
+struct HitTarget {
+    sf::Vector2f pos;
+    int node;
+    bool band;           // true: node'un çocukları tek bant olarak çizildi
+};
+
+class TreeRenderer {
+public:
+    sf::VertexArray quads{ sf::PrimitiveType::Triangles };
+    sf::VertexArray lines{ sf::PrimitiveType::Lines };
+    vector<HitTarget> hits;
+    vector<int> labelNodes;
+    size_t drawnNodes = 0;
+    size_t drawnBands = 0;
+
+    void build(const ExplorerTree& tree, const Camera& cam, float left, float width, float height, int selected) {
+        quads.clear();
+        lines.clear();
+        hits.clear();
+        labelNodes.clear();
+        drawnNodes = drawnBands = 0;
+        if (tree.nodes.empty()) return;
+
+        this->cam = cam;
+        this->left = left;
+        this->height = height;
+        this->right = left + width;
+        this->selected = selected;
+        viewMin = cam.centerY - height / 2 / cam.zoom;
+        viewMax = cam.centerY + height / 2 / cam.zoom;
+        buildNode(tree, 0);
+    }
+
+    sf::Vector2f nodePos(const ViewNode& v) const {
+        return { screenX(v.rec.depth), screenY((v.leafStart + v.leafSpan * 0.5) * SLOT) };
+    }
+
+private:
+    Camera cam;
+    float left = 0, right = 0, height = 0;
+    double viewMin = 0, viewMax = 0;
+    int selected = -1;
+
+    float screenX(int depth) const { return left + TREE_LEFT + depth * LEVEL_PX + cam.panX; }
+    float screenY(double worldY) const { return (float)((worldY - cam.centerY) * cam.zoom + height / 2); }
+
+    void addQuad(sf::Vector2f a, sf::Vector2f b, sf::Color c) {
+        sf::Vertex v[4] = { { a, c, {} }, { { b.x, a.y }, c, {} }, { b, c, {} }, { { a.x, b.y }, c, {} } };
+        quads.append(v[0]); quads.append(v[1]); quads.append(v[2]);
+        quads.append(v[0]); quads.append(v[2]); quads.append(v[3]);
+    }
+
+    void addLine(sf::Vector2f a, sf::Vector2f b, sf::Color c) {
+        lines.append({ a, c, {} });
+        lines.append({ b, c, {} });
+    }
+
+    static sf::Color nodeColor(const ExplorerTree& tree, const ViewNode& v) {
+        if (v.rec.info == INFO_TRANSPOSITION) return sf::Color(155, 89, 182);
+        if (tree.hasHiddenChildren(v)) return sf::Color(149, 165, 166);
+        if (v.rec.type == NODE_ROOT) return sf::Color(241, 196, 15);
+        return v.rec.type == NODE_MAX ? sf::Color(212, 237, 218) : sf::Color(248, 215, 218);
+    }
+
+    void buildNode(const ExplorerTree& tree, int i) {
+        const ViewNode& v = tree.nodes[i];
+        double top = v.leafStart * SLOT, bottom = (v.leafStart + v.leafSpan) * SLOT;
+        if (bottom < viewMin || top > viewMax) return;
+
+        sf::Vector2f p = nodePos(v);
+        float h = NODE_PX / 2;
+
+        if (v.expanded && v.childCount > 0) {
+            float childX = screenX(v.rec.depth + 1);
+            double childPx = (bottom - top) * cam.zoom / v.childCount;
+
+            if (childPx < LOD_MIN_PX) {
+                // Çocuklar ayırt edilemeyecek kadar sık: tek bant + tek kenar
+                float y0 = max(screenY(top), -1.f), y1 = min(screenY(bottom), height + 1);
+                addLine(p, { childX, (y0 + y1) / 2 }, sf::Color(120, 120, 120));
+                addQuad({ childX - h, y0 }, { childX + h, max(y1, y0 + 1) }, sf::Color(127, 140, 141));
+                hits.push_back({ { childX, (y0 + y1) / 2 }, i, true });
+                drawnBands++;
+            } else {
+                for (uint32_t c = 0; c < v.childCount; c++) {
+                    const ViewNode& child = tree.nodes[v.firstChild + c];
+                    double cy = (child.leafStart + child.leafSpan * 0.5) * SLOT;
+                    // Kenar görünür aralıktan geçiyorsa çizilir (uç noktalar ekran dışında olabilir)
+                    double lo = min(cy, (top + bottom) / 2), hi = max(cy, (top + bottom) / 2);
+                    if (hi >= viewMin && lo <= viewMax) addLine(p, { childX, screenY(cy) }, sf::Color(150, 150, 150));
+                    buildNode(tree, v.firstChild + (int)c);
+                }
+            }
+        }
+
+        if (v.rec.info == INFO_PRUNED_ALPHA || v.rec.info == INFO_PRUNED_BETA)
+            addQuad({ p.x - h - 2, p.y - h - 2 }, { p.x + h + 2, p.y + h + 2 }, sf::Color(230, 126, 34));
+        if (i == selected)
+            addQuad({ p.x - h - 4, p.y - h - 4 }, { p.x + h + 4, p.y + h + 4 }, sf::Color::Yellow);
+        addQuad({ p.x - h, p.y - h }, { p.x + h, p.y + h }, nodeColor(tree, v));
+        hits.push_back({ p, i, false });
+        drawnNodes++;
+
+        if (v.leafSpan * SLOT * cam.zoom >= LABEL_PX && (int)labelNodes.size() < MAX_LABELS && p.x < right)
+            labelNodes.push_back(i);
+    }
+};
+
+//==================================================
+// UI
+//==================================================
+void drawBoard(sf::RenderWindow& win, const vector<int8_t>& board, int n) {
+    sf::VertexArray cells(sf::PrimitiveType::Triangles);
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            int v = board[i * n + j];
+            sf::Color c = sf::Color(180, 180, 180);
+            if (v == BLOCKED) c = sf::Color::Black;
+            else if (v == AI_PAWN) c = sf::Color::Blue;
+            else if (v == HU_PAWN) c = sf::Color::Red;
+
+            sf::Vector2f a((float)(j * CELL + 12), (float)(i * CELL + 12));
+            sf::Vector2f b(a.x + CELL - 2, a.y + CELL - 2);
+            sf::Vertex q[4] = { { a, c, {} }, { { b.x, a.y }, c, {} }, { b, c, {} }, { { a.x, b.y }, c, {} } };
+            cells.append(q[0]); cells.append(q[1]); cells.append(q[2]);
+            cells.append(q[0]); cells.append(q[2]); cells.append(q[3]);
+        }
+    }
+    win.draw(cells);
+}
+
+string formatScore(int32_t s) {
+    if (s >= 900000) return "WIN";
+    if (s <= -900000) return "LOSE";
+    return to_string(s);
+}
+
+// Multi-PV satırları: "skor  x,y>x,y  x,y>x,y ..." (kesilen satırlar "..." ile biter)
+string formatLines(const vector<vector<LineMove>>& lines) {
+    if (lines.size() < 2) return "";
+    string out;
+    for (const auto& line : lines) {
+        if (line.empty()) continue;
+        string text = "  " + formatScore(line[0].score) + " ";
+        for (size_t j = 0; j < line.size() && j < 4; j++)
+            text += " " + to_string(line[j].moveX) + "," + to_string(line[j].moveY) + ">" +
+                    to_string(line[j].removeX) + "," + to_string(line[j].removeY);
+        if (line.size() > 4) text += " ...";
+        out += text + "\n";
+    }
+    return out;
+}
+
+// Kamerayı açık ağacın tamamı ekrana sığacak şekilde ayarlar
+void fitCamera(Camera& cam, const ExplorerTree& tree, float height) {
+    if (tree.nodes.empty()) return;
+    double span = tree.nodes[0].leafSpan * SLOT;
+    cam.zoom = max(1e-6, (height - 40) / span);
+    cam.centerY = span / 2;
+    cam.panX = 0;
+}
+
+//==================================================
+// MAIN
+//==================================================
+int main(int argc, char* argv[]) {
+    string path = argc >= 2 ? argv[1] : "game_data.bin";
+    BinaryLog log;
+    if (!log.open(path) || log.turnCount() == 0) {
+        cout << "Kullanim: ./explorer [game_data.bin]  (once ./tree ile oyun oynayin)" << endl;
+        return 1;
+    }
+
+    sf::RenderWindow window(sf::VideoMode({ (unsigned int)WINDOW_W, (unsigned int)WINDOW_H }), "Search Tree Explorer");
+    window.setFramerateLimit(60);
+
+    sf::Font font;
+    if (!font.openFromFile("arial.ttf")) {
+        if (!font.openFromFile("/Library/Fonts/Arial.ttf")) {
+            // Font yoksa yazısız devam et
+        }
+    }
+    bool hasFont = font.getInfo().family != "";
+
+    int turnIndex = 0;
+    TurnData turn = log.loadTurn(turnIndex);
+    ExplorerTree tree;
+    TreeRenderer renderer;
+    Camera cam;
+    int selected = 0;
+
+    auto openTurn = [&](int i) {
+        turnIndex = i;
+        turn = log.loadTurn(i);
+        tree.reset(log, turn);
+        tree.layout();
+        selected = 0;
+        fitCamera(cam, tree, (float)window.getSize().y);
+    };
+    openTurn(0);
+
+    bool dirty = true;
+    bool dragging = false, dragged = false;
+    sf::Vector2i lastMouse;
+
+    while (window.isOpen()) {
+        sf::Vector2u size = window.getSize();
+        float treeW = (float)size.x - PANEL_W, treeH = (float)size.y;
+
+        while (const std::optional<sf::Event> event = window.pollEvent()) {
+            if (event->is<sf::Event::Closed>()) {
+                window.close();
+            }
+            else if (const auto* resized = event->getIf<sf::Event::Resized>()) {
+                window.setView(sf::View(sf::FloatRect({ 0.f, 0.f }, { (float)resized->size.x, (float)resized->size.y })));
+                dirty = true;
+            }
+            else if (const auto* key = event->getIf<sf::Event::KeyPressed>()) {
+                if (key->code == sf::Keyboard::Key::Right && turnIndex + 1 < log.turnCount()) openTurn(turnIndex + 1);
+                else if (key->code == sf::Keyboard::Key::Left && turnIndex > 0) openTurn(turnIndex - 1);
+                else if (key->code == sf::Keyboard::Key::Home) fitCamera(cam, tree, treeH);
+                else if (key->code == sf::Keyboard::Key::A) {
+                    auto start = chrono::steady_clock::now();
+                    tree.expandAll(log, turn);
+                    tree.layout();
+                    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+                    cout << "Tur " << turn.entry.turn << ": " << tree.nodes.size() << " düğüm açıldı, " << ms << " ms" << endl;
+                    fitCamera(cam, tree, treeH);
+                }
+                else if (key->code == sf::Keyboard::Key::C) {
+                    tree.collapseAll();
+                    tree.layout();
+                    fitCamera(cam, tree, treeH);
+                }
+                else if (key->code == sf::Keyboard::Key::Escape) window.close();
+                dirty = true;
+            }
+            else if (const auto* wheel = event->getIf<sf::Event::MouseWheelScrolled>()) {
+                // İmlecin altındaki dünya noktası yerinde kalır
+                double anchor = cam.centerY + (wheel->position.y - treeH / 2) / cam.zoom;
+                cam.zoom *= pow(1.25, wheel->delta);
+                cam.centerY = anchor - (wheel->position.y - treeH / 2) / cam.zoom;
+                dirty = true;
+            }
+            else if (const auto* pressed = event->getIf<sf::Event::MouseButtonPressed>()) {
+                if (pressed->button == sf::Mouse::Button::Left && pressed->position.x >= PANEL_W) {
+                    dragging = true;
+                    dragged = false;
+                    lastMouse = pressed->position;
+                }
+            }
+            else if (const auto* moved = event->getIf<sf::Event::MouseMoved>()) {
+                if (dragging) {
+                    sf::Vector2i d = moved->position - lastMouse;
+                    if (abs(d.x) + abs(d.y) > 2) dragged = true;
+                    if (dragged) {
+                        cam.panX += (float)d.x;
+                        cam.centerY -= d.y / cam.zoom;
+                        lastMouse = moved->position;
+                        dirty = true;
+                    }
+                }
+            }
+            else if (const auto* released = event->getIf<sf::Event::MouseButtonReleased>()) {
+                if (released->button != sf::Mouse::Button::Left || !dragging) continue;
+                dragging = false;
+                if (dragged) continue;
+
+                // Tıklama: en yakın düğüm aç/kapa, banda tıklanırsa çocuklar görünene kadar yakınlaş
+                sf::Vector2f m((float)released->position.x, (float)released->position.y);
+                const HitTarget* best = nullptr;
+                float bestDist = NODE_PX * 1.5f;
+                for (const auto& h : renderer.hits) {
+                    float dist = h.band ? fabs(m.x - h.pos.x) : hypot(m.x - h.pos.x, m.y - h.pos.y);
+                    if (h.band) {
+                        const ViewNode& v = tree.nodes[h.node];
+                        double top = v.leafStart * SLOT, bottom = (v.leafStart + v.leafSpan) * SLOT;
+                        double wy = cam.centerY + (m.y - treeH / 2) / cam.zoom;
+                        if (wy < top || wy > bottom) continue;
+                    }
+                    if (dist < bestDist) { bestDist = dist; best = &h; }
+                }
+                if (best && best->band) {
+                    const ViewNode& v = tree.nodes[best->node];
+                    double anchor = cam.centerY + (m.y - treeH / 2) / cam.zoom;
+                    cam.zoom = 4 * LOD_MIN_PX * v.childCount / (v.leafSpan * SLOT);
+                    cam.centerY = anchor;
+                } else if (best) {
+                    selected = best->node;
+                    tree.toggle(log, turn, selected);
+                    tree.layout();
+                }
+                dirty = true;
+            }
+        }
+
+        if (dirty) {
+            renderer.build(tree, cam, (float)PANEL_W, treeW, treeH, selected);
+            dirty = false;
+        }
+
+        window.clear(sf::Color(30, 30, 36));
+        window.draw(renderer.lines);
+        window.draw(renderer.quads);
+
+        if (hasFont) {
+            sf::Text label(font, "", 11);
+            label.setFillColor(sf::Color::White);
+            for (int i : renderer.labelNodes) {
+                sf::Vector2f p = renderer.nodePos(tree.nodes[i]);
+                label.setString(formatScore(tree.nodes[i].rec.score));
+                label.setPosition(sf::Vector2f(p.x + NODE_PX, p.y - 7));
+                window.draw(label);
+            }
+        }
+
+        // Sol panel: tahta + tur ve seçili düğüm bilgisi
+        sf::RectangleShape panel(sf::Vector2f((float)PANEL_W, (float)size.y));
+        panel.setFillColor(sf::Color(44, 62, 80));
+        window.draw(panel);
+        drawBoard(window, turn.board, log.n);
+
+        if (hasFont) {
+            const ViewNode& sel = tree.nodes[selected];
+            string info =
+                "Tur " + to_string(turn.entry.turn) + "  (" + to_string(turnIndex + 1) + "/" + to_string(log.turnCount()) + ")\n"
+                "Best Score: " + formatScore(turn.entry.bestScore) + "\n"
+                "Dugum: " + to_string(turn.entry.nodeCount) + "  Sure: " + to_string(turn.timeUs / 1000) + " ms" +
+                (turn.multiPv > 1 ? "  Multi-PV: " + to_string(turn.multiPv) : "") + "\n" +
+                formatLines(turn.lines) +
+                "Transpozisyon: " + to_string(turn.transpositions) + "  Tekrar: " + to_string(turn.savedNodes) + "\n"
+                "Yuklu: " + to_string(tree.nodes.size()) + "  Cizilen: " + to_string(renderer.drawnNodes) +
+                " (+" + to_string(renderer.drawnBands) + " bant)\n\n"
+                "Secili: #" + to_string(sel.rec.id) + " " + NODE_TYPE_NAMES[sel.rec.type] + "\n"
+                "Skor: " + formatScore(sel.rec.score) + "  Derinlik: " + to_string(sel.rec.depth) + "\n"
+                "Cocuk: " + to_string(sel.childCount) + "  " + NODE_INFO_NAMES[sel.rec.info] + "\n"
+                "Ulasilma: " + to_string(turn.multiplicity.count(sel.rec.id) ? turn.multiplicity.at(sel.rec.id) : 1) + " kez\n\n"
+                "Tikla: ac/kapa   Surukle: kaydir\n"
+                "Tekerlek: yakinlas   Sol/Sag: tur\n"
+                "A: hepsini ac   C: kapat   Home: sigdir";
+            sf::Text text(font, info, 14);
+            text.setFillColor(sf::Color::White);
+            text.setPosition(sf::Vector2f(12.f, (float)(log.n * CELL + 24)));
+            window.draw(text);
+        }
+
+        window.display();
+    }
+
+    return 0;
+}
@@ -6,6 +6,20 @@
 #include <string>
 #include <fstream> 
 #include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <chrono>
+#include <charconv>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <string_view>
+#include <unordered_map>
 
 using namespace std;
 
@@ -31,27 +45,80 @@ int dx[8] = { -1,-1,-1, 0, 0, 1, 1, 1 };
 int dy[8] = { -1, 0, 1,-1, 1,-1, 0, 1 };
 
 //==================================================
-// LOGGING STRUCTURES (JSON Export için)
+// LOGGING STRUCTURES
 //==================================================
+// type/info tek byte'lık kodlar; isimler JS çıktısı ve viewer.html için
+enum NodeType : uint8_t { NODE_ROOT, NODE_MAX, NODE_MIN };
+// INFO_TRANSPOSITION: DAG modunda bu turda daha önce loglanmış bir pozisyona
+// referans; id o düğümün id'si, çocukları onunkilerdir (bkz. SELECTIVE CAPTURE)
+enum NodeInfo : uint8_t { INFO_NONE, INFO_START, INFO_LEAF, INFO_PRUNED_BETA, INFO_PRUNED_ALPHA, INFO_TRANSPOSITION };
+
+const char* const NODE_TYPE_NAMES[] = { "ROOT", "MAX", "MIN" };
+const char* const NODE_INFO_NAMES[] = { "", "Start", "Leaf", "Pruned (Beta)", "Pruned (Alpha)", "Transposition" };
+
+// 16 byte'lık düz kayıt: heap yok, kopyası tek bir 16 byte'lık yazma
 struct LogNode {
-    int id;
-    int parentId;
-    int score;
-    int depth;
-    string type; // "MAX" or "MIN"
-    string info; // "Leaf", "Pruned" etc.
+    int32_t  id;
+    int32_t  parentId;
+    int32_t  score;
+    uint8_t  depth;
+    NodeType type;
+    NodeInfo info;
+    uint8_t  reserved;
 };
-
-struct LogTurn {
-    int turnNumber;
-    vector<LogNode> nodes; // Bu turda oluşan ağaç
-    int bestMoveScore;
-    int boardState[N][N];  // O anki tahta
+static_assert(sizeof(LogNode) == 16, "LogNode 16 byte olmali");
+static_assert(is_trivially_copyable_v<LogNode>, "LogNode POD olmali");
+
+// Log dosyası formatı:
+//   LOG_BINARY -> game_data.bin (kolon bazlı ikili format, viewer.html önce bunu dener)
+//   LOG_JS     -> game_data.js  (GAME_DATA metin formatı)
+enum LogFormat { LOG_JS, LOG_BINARY };
+const LogFormat LOG_FORMAT = LOG_BINARY;
+
+// Düğümler arama sırasında sabit boyutlu chunk'lara yazılır, dolan chunk arka
+// plandaki yazıcı thread'e verilip diske akıtılır. Bellek kullanımı ağacın
+// büyüklüğünden bağımsız: en fazla LOG_MAX_CHUNKS chunk.
+const size_t LOG_CHUNK_NODES = 1 << 15;  // chunk başına düğüm (512 KB)
+const int    LOG_MAX_CHUNKS  = 4;        // yazıcı gerideyse arama en fazla bu kadar önde gider
+
+// Chunk havuzu: chunk'lar bir kez ayrılır, hiçbir zaman taşınmaz ya da
+// serbest bırakılmaz; yazılan chunk havuza döner ve sonraki turlarda da
+// yeniden kullanılır.
+struct LogChunk {
+    uint32_t count = 0;
+    LogNode nodes[LOG_CHUNK_NODES];
 };
 
-// Global Log Verisi
-vector<LogTurn> gameLog;
-vector<LogNode> currentTurnNodes; 
+class LogArena {
+public:
+    // Boş chunk ver; yoksa sınıra kadar yenisini ayır, sınırdaysa iade bekle.
+    LogChunk* acquire() {
+        unique_lock<mutex> lk(mtx);
+        if (freeChunks.empty() && (int)chunks.size() < LOG_MAX_CHUNKS) {
+            chunks.push_back(make_unique<LogChunk>());
+            return chunks.back().get();
+        }
+        chunkFree.wait(lk, [&] { return !freeChunks.empty(); });
+        LogChunk* c = freeChunks.back();
+        freeChunks.pop_back();
+        return c;
+    }
+
+    void release(LogChunk* c) {
+        c->count = 0;
+        {
+            lock_guard<mutex> lk(mtx);
+            freeChunks.push_back(c);
+        }
+        chunkFree.notify_one();
+    }
+
+private:
+    vector<unique_ptr<LogChunk>> chunks;
+    vector<LogChunk*> freeChunks;
+    mutex mtx;
+    condition_variable chunkFree;
+};
 
 //==================================================
 // STATE STRUCTURE
@@ -69,61 +136,792 @@ struct Move {
 };
 
 //==================================================
-// FILE SAVING FUNCTION (game_data.js)
+// TURN SUMMARY (arama istatistikleri, C++ tarafında hesaplanır)
 //==================================================
-void saveGameLog() {
-    ofstream file("game_data.js");
-    if (!file.is_open()) {
-        cout << "Hata: Dosya oluşturulamadı!" << endl;
-        return;
+// Yakalama modundan bağımsız olarak aranan her düğüm sayılır; viewer bu
+// özeti ağacı çözmeden anında gösterir.
+struct DepthStats {
+    uint32_t nodes;      // bu derinlikte aranan düğüm
+    uint32_t cutoffs;    // alpha/beta kesmesi olan düğüm
+    uint32_t generated;  // üretilen çocuk hamle (aranan çocuklar = bir alt derinliğin nodes'u)
+};
+
+struct ScoredMove {
+    Move move;
+    int score;
+};
+
+struct TurnSummary {
+    uint32_t timeUs = 0;
+    vector<DepthStats> depths;    // indeks = düğüm derinliği
+    vector<ScoredMove> rootMoves; // kök hamleleri, arama sırasıyla (alpha-beta sınırları)
+    uint32_t multiPv = 1;         // skoru kesin olan en iyi kök hamle sayısı (--multipv)
+    vector<vector<ScoredMove>> lines; // bu en iyi multiPv kök hamlesi, skora göre: hamle + çocuğun PV'si
+    vector<ScoredMove> pv;        // ana varyasyon
+
+    // DAG modu (--dag): tekrar eden pozisyonlar
+    uint32_t transpositions = 0;  // referansla değiştirilen düğüm
+    uint32_t savedNodes = 0;      // bu referansların altında yeniden aranan düğüm
+    vector<pair<int32_t, uint32_t>> multiplicity; // düğüm id -> kaç kez ulaşıldı (> 1 olanlar)
+};
+
+//==================================================
+// JSON NODE ENCODER (game_data.js için hızlı yol)
+//==================================================
+// Düğümler ofstream yerine std::to_chars ile önceden ayrılmış tampona
+// yazılır. Çıktı GAME_DATA şemasıyla (ve eski ofstream çıktısıyla) byte
+// byte aynıdır. Chunk'lar birbirinden bağımsız kodlandığı için EncoderPool
+// üzerinde paralel çalışır; sıralı yazımı yazıcı thread yapar.
+const size_t JSON_MAX_NODE_BYTES = 160; // ",\n" + sabit metin + 4 int + en uzun isimler
+
+inline char* putText(char* p, string_view text) {
+    memcpy(p, text.data(), text.size());
+    return p + text.size();
+}
+
+inline char* putInt(char* p, int v) {
+    return to_chars(p, p + 11, v).ptr;
+}
+
+// firstInTurn: chunk turun ilk düğümüyle mi başlıyor (başına ",\n" konmaz).
+// Yazılan byte sayısını döner.
+size_t encodeNodesJs(const LogChunk& chunk, bool firstInTurn, vector<char>& out) {
+    static const string_view typeNames[] = { NODE_TYPE_NAMES[0], NODE_TYPE_NAMES[1], NODE_TYPE_NAMES[2] };
+    static const string_view infoNames[] = { NODE_INFO_NAMES[0], NODE_INFO_NAMES[1], NODE_INFO_NAMES[2],
+                                             NODE_INFO_NAMES[3], NODE_INFO_NAMES[4], NODE_INFO_NAMES[5] };
+
+    if (out.size() < chunk.count * JSON_MAX_NODE_BYTES) out.resize(chunk.count * JSON_MAX_NODE_BYTES);
+    char* p = out.data();
+    for (uint32_t k = 0; k < chunk.count; k++) {
+        const auto& n = chunk.nodes[k];
+        if (k > 0 || !firstInTurn) p = putText(p, ",\n");
+        p = putText(p, "      { \"id\": ");
+        p = putInt(p, n.id);
+        p = putText(p, ", \"parent\": ");
+        p = putInt(p, n.parentId);
+        p = putText(p, ", \"score\": ");
+        p = putInt(p, n.score);
+        p = putText(p, ", \"depth\": ");
+        p = putInt(p, n.depth);
+        p = putText(p, ", \"type\": \"");
+        p = putText(p, typeNames[n.type]);
+        p = putText(p, "\", \"info\": \"");
+        p = putText(p, infoNames[n.info]);
+        p = putText(p, "\" }");
+    }
+    return (size_t)(p - out.data());
+}
+
+// Sabit sayıda thread'li basit iş havuzu
+class EncoderPool {
+public:
+    explicit EncoderPool(int threadCount) {
+        for (int i = 0; i < threadCount; i++) workers.emplace_back([this] { workerLoop(); });
+    }
+
+    ~EncoderPool() {
+        {
+            lock_guard<mutex> lk(mtx);
+            stopping = true;
+        }
+        taskReady.notify_all();
+        for (auto& t : workers) t.join();
+    }
+
+    future<void> submit(function<void()> fn) {
+        packaged_task<void()> task(std::move(fn));
+        future<void> done = task.get_future();
+        {
+            lock_guard<mutex> lk(mtx);
+            tasks.push_back(std::move(task));
+        }
+        taskReady.notify_one();
+        return done;
+    }
+
+private:
+    void workerLoop() {
+        while (true) {
+            packaged_task<void()> task;
+            {
+                unique_lock<mutex> lk(mtx);
+                taskReady.wait(lk, [&] { return stopping || !tasks.empty(); });
+                if (tasks.empty()) return;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    vector<thread> workers;
+    deque<packaged_task<void()>> tasks;
+    mutex mtx;
+    condition_variable taskReady;
+    bool stopping = false;
+};
+
+//==================================================
+// STREAMING TREE LOGGER (game_data.bin / game_data.js)
+//==================================================
+// game_data.js her turda şu şekilde büyür:
+//   { "turn": n, "board": [...], "nodes": [ ...akış... ], "bestScore": x, "summary": {...} }
+// bestScore ve özet arama bitince bilindiği için node listesinden sonra yazılır.
+//
+// game_data.bin (little-endian, her bölüm 4 byte hizalı):
+//   Dosya başlığı : "TLOG" | u32 version | u32 N | u32 LOG_CHUNK_NODES
+//   Her tur       : i32 turn | i8 board[N*N] (4'e tamamlanır) | chunk'lar
+//   Chunk         : u32 count | i32 id[] | i32 parent[] | i32 score[]
+//                   | u8 depth[] | u8 type[] | u8 info[] (4'e tamamlanır)
+//                   (her dolu LogChunk dosyada da bir chunk olur; turun son
+//                   chunk'ı dışında hepsi LOG_CHUNK_NODES düğüm içerir)
+//   Tur özeti     : u32 timeUs | u32 depthCount | depthCount x (u32 nodes, cutoffs, generated)
+//                   | u32 rootCount | rootCount x hamle | u32 pvLength | pvLength x hamle
+//                   (hamle = i8 moveX, moveY, removeX, removeY | i32 score)
+//                   | u32 transpositions | u32 savedNodes
+//                   | u32 multCount | multCount x (i32 id, u32 multiplicity)
+//                   | u32 multiPv | u32 lineCount | lineCount x (u32 length | length x hamle)
+//   Çocuk indeksi : u32 groupCount | groupCount x (i32 parentId, u32 start, u32 count)
+//                   | u32 chunkCount | chunkCount x u64 chunkOffset
+//                   (start = turdaki kayıt sırası; kökün grubu parentId = -1)
+//   Tur indeksi   : tur başına u64 offset | i32 turn | i32 bestScore
+//                   | u32 nodeCount | u32 chunkCount | u64 summaryOffset
+//                   | u64 childIndexOffset (40 byte)
+//   Dosya sonu    : u64 indexOffset | u32 turnCount | "TEND"
+// Kapanışta indeks yazılır; her tur sonunda dosya flush edilir.
+// Çocuk indeksiyle viewer bir düğümün çocuklarını byte aralığıyla okur
+// (chunkOffset + kolon içi konum); tüm dosyayı yüklemesi gerekmez.
+// DAG modunda INFO_TRANSPOSITION kayıtları aynı id'yi tekrar kullanır;
+// çocuk indeksinde yalnızca ilk (tanım) kaydın grubu vardır.
+const uint32_t BIN_LOG_VERSION = 6;
+
+class TreeLogger {
+public:
+    ~TreeLogger() { close(); }
+
+    bool open(const string& path, LogFormat fmt) {
+        format = fmt;
+        filePath = path;
+        file.open(path, ios::binary);
+        if (!file.is_open()) return false;
+
+        if (format == LOG_BINARY) {
+            writeTag("TLOG");
+            writeU32(BIN_LOG_VERSION);
+            writeU32(N);
+            writeU32((uint32_t)LOG_CHUNK_NODES);
+        } else {
+            file << "const GAME_DATA = [\n";
+            int threads = (int)thread::hardware_concurrency() - 1;
+            encoders = make_unique<EncoderPool>(max(1, min(threads, LOG_MAX_CHUNKS)));
+        }
+
+        active = arena.acquire();
+        writer = thread(&TreeLogger::writerLoop, this);
+        enabled = true;
+        return true;
+    }
+
+    bool isEnabled() const { return enabled; }
+    int turnCount() const { return turns; }
+
+    // Düğüm id'leri tur başına 0'dan başlar (log kapalıyken de sayılır)
+    int32_t newNodeId() { return nextNodeId++; }
+
+    void beginTurn(int turnNumber, const int board[N][N]) {
+        nextNodeId = 0;
+        if (!enabled) return;
+        Job job{ JOB_TURN_BEGIN, nullptr, turnNumber, {}, {} };
+        for (int i = 0; i < N; i++)
+            for (int j = 0; j < N; j++)
+                job.board[i][j] = board[i][j];
+        pushJob(job);
+    }
+
+    // Arama thread'inin sıcak yolu: 16 byte kopya, chunk dolmadıkça kilit yok.
+    void logNode(const LogNode& n) {
+        if (!enabled) return;
+        active->nodes[active->count++] = n;
+        if (active->count == LOG_CHUNK_NODES) submitActive();
+    }
+
+    void endTurn(int bestScore, TurnSummary summary) {
+        if (!enabled) return;
+        if (active->count > 0) submitActive();
+        Job job{ JOB_TURN_END, nullptr, bestScore, {}, {} };
+        job.summary = std::move(summary);
+        pushJob(std::move(job));
+        turns++;
+    }
+
+    // Pencere kapanırken / oyun bitince çağrılır. Kuyruktaki her şey yazılır.
+    void close() {
+        if (!enabled) return;
+        enabled = false;
+        if (active->count > 0) submitActive();
+        pushJob({ JOB_CLOSE, nullptr, 0, {}, {} });
+        writer.join();
+        encoders.reset();
+        file.close();
+        cout << "BASARILI: Oyun verisi '" << filePath << "' olarak kaydedildi." << endl;
+    }
+
+private:
+    enum JobKind { JOB_TURN_BEGIN, JOB_NODES, JOB_TURN_END, JOB_CLOSE };
+
+    struct Job {
+        JobKind kind;
+        LogChunk* nodes;        // JOB_NODES: dolu chunk
+        int value;              // JOB_TURN_BEGIN: tur no, JOB_TURN_END: bestScore
+        int board[N][N];        // JOB_TURN_BEGIN: o anki tahta
+        TurnSummary summary;    // JOB_TURN_END
+    };
+
+    struct EncodedNodes {
+        LogChunk* chunk;
+        vector<char>* text;
+        size_t bytes = 0;
+        future<void> done;
+    };
+
+    struct TurnIndex {
+        uint64_t offset;
+        int32_t turn;
+        int32_t bestScore;
+        uint32_t nodeCount;
+        uint32_t chunkCount;
+        uint64_t summaryOffset;
+        uint64_t childIndexOffset;
+    };
+
+    // Aynı ebeveynin ardışık çocukları (TreeCapture bunu garanti eder)
+    struct ChildGroup {
+        int32_t parentId;
+        uint32_t start;
+        uint32_t count;
+    };
+
+    void pushJob(Job job) {
+        {
+            lock_guard<mutex> lk(mtx);
+            jobs.push_back(std::move(job));
+        }
+        jobReady.notify_one();
+    }
+
+    // Aktif chunk'ı yazıcıya ver; havuz doluysa yazıcı yetişene kadar bekle.
+    void submitActive() {
+        pushJob({ JOB_NODES, active, 0, {}, {} });
+        active = arena.acquire();
     }
 
-    file << "const GAME_DATA = [\n";
+    // --- İkili yazım yardımcıları (yalnızca yazıcı thread) ---
+    void writeBytes(const void* p, size_t n) {
+        file.write((const char*)p, (streamsize)n);
+        bytesWritten += n;
+    }
+    void writeU32(uint32_t v) { writeBytes(&v, 4); }
+    void writeTag(const char* tag) { writeBytes(tag, 4); }
+    void padTo4() {
+        static const char zeros[4] = { 0, 0, 0, 0 };
+        if (bytesWritten % 4) writeBytes(zeros, 4 - bytesWritten % 4);
+    }
 
-    for (size_t i = 0; i < gameLog.size(); i++) {
-        const auto& turn = gameLog[i];
+    void writeTurnBegin(const Job& job) {
+        if (format == LOG_BINARY) {
+            curTurn = { bytesWritten, job.value, 0, 0, 0, 0, 0 };
+            childGroups.clear();
+            chunkOffsets.clear();
+            writeU32((uint32_t)job.value);
+            int8_t cells[N * N];
+            for (int i = 0; i < N; i++)
+                for (int j = 0; j < N; j++)
+                    cells[i * N + j] = (int8_t)job.board[i][j];
+            writeBytes(cells, sizeof(cells));
+            padTo4();
+            return;
+        }
+
+        if (turnsWritten > 0) file << ",\n";
         file << "  {\n";
-        file << "    \"turn\": " << turn.turnNumber << ",\n";
-        file << "    \"bestScore\": " << turn.bestMoveScore << ",\n";
-        
-        // Board Array
+        file << "    \"turn\": " << job.value << ",\n";
         file << "    \"board\": [\n";
-        for(int r=0; r<N; r++) {
+        for (int r = 0; r < N; r++) {
             file << "      [";
-            for(int c=0; c<N; c++) {
-                file << turn.boardState[r][c];
-                if(c < N-1) file << ",";
+            for (int c = 0; c < N; c++) {
+                file << job.board[r][c];
+                if (c < N - 1) file << ",";
             }
             file << "]";
-            if(r < N-1) file << ",";
+            if (r < N - 1) file << ",";
             file << "\n";
         }
         file << "    ],\n";
-
-        // Tree Nodes
         file << "    \"nodes\": [\n";
-        for (size_t j = 0; j < turn.nodes.size(); j++) {
-            const auto& node = turn.nodes[j];
-            file << "      { "
-                 << "\"id\": " << node.id << ", "
-                 << "\"parent\": " << node.parentId << ", "
-                 << "\"score\": " << node.score << ", "
-                 << "\"depth\": " << node.depth << ", "
-                 << "\"type\": \"" << node.type << "\", "
-                 << "\"info\": \"" << node.info << "\""
-                 << " }";
-            if (j < turn.nodes.size() - 1) file << ",";
-            file << "\n";
+        firstNodeInTurn = true;
+    }
+
+    // JS: chunk havuzda kodlanır, sırası gelince tek write ile diske gider
+    void encodeNodesAsync(LogChunk* chunk) {
+        vector<char>* text;
+        if (freeText.empty()) {
+            textBuffers.push_back(make_unique<vector<char>>());
+            text = textBuffers.back().get();
+        } else {
+            text = freeText.back();
+            freeText.pop_back();
         }
-        file << "    ]\n";
-        file << "  }";
-        if (i < gameLog.size() - 1) file << ",";
-        file << "\n";
+
+        bool first = firstNodeInTurn;
+        firstNodeInTurn = false;
+        auto pending = make_unique<EncodedNodes>();
+        EncodedNodes* e = pending.get();
+        e->chunk = chunk;
+        e->text = text;
+        e->done = encoders->submit([e, first] { e->bytes = encodeNodesJs(*e->chunk, first, *e->text); });
+        encoded.push_back(std::move(pending));
     }
-    file << "];\n";
-    file.close();
-    cout << "BASARILI: Oyun verisi 'game_data.js' olarak kaydedildi." << endl;
-}
+
+    void writeOldestEncoded() {
+        EncodedNodes& e = *encoded.front();
+        e.done.get();
+        writeBytes(e.text->data(), e.bytes);
+        arena.release(e.chunk);
+        freeText.push_back(e.text);
+        encoded.pop_front();
+    }
+
+    void writeNodes(LogChunk* chunk) {
+        if (format == LOG_BINARY) {
+            writeChunk(*chunk);
+            arena.release(chunk);
+        } else {
+            encodeNodesAsync(chunk);
+        }
+    }
+
+    // LogChunk (satır) -> dosya chunk'ı (kolon): önce int32 kolonlar, sonra byte kolonlar
+    void writeChunk(const LogChunk& chunk) {
+        size_t count = chunk.count;
+        chunkOffsets.push_back(bytesWritten);
+        chunkBytes.resize(count * 15);
+        int32_t* ids     = (int32_t*)chunkBytes.data();
+        int32_t* parents = ids + count;
+        int32_t* scores  = parents + count;
+        uint8_t* depths  = (uint8_t*)(scores + count);
+        uint8_t* types   = depths + count;
+        uint8_t* infos   = types + count;
+        for (size_t k = 0; k < count; k++) {
+            const auto& n = chunk.nodes[k];
+            if (childGroups.empty() || childGroups.back().parentId != n.parentId) {
+                childGroups.push_back({ n.parentId, curTurn.nodeCount + (uint32_t)k, 0 });
+            }
+            childGroups.back().count++;
+            ids[k]     = n.id;
+            parents[k] = n.parentId;
+            scores[k]  = n.score;
+            depths[k]  = n.depth;
+            types[k]   = n.type;
+            infos[k]   = n.info;
+        }
+        writeU32((uint32_t)count);
+        writeBytes(chunkBytes.data(), chunkBytes.size());
+        padTo4();
+        curTurn.nodeCount += (uint32_t)count;
+        curTurn.chunkCount++;
+    }
+
+    void writeScoredMove(const ScoredMove& m) {
+        int8_t coords[4] = { (int8_t)m.move.moveX, (int8_t)m.move.moveY,
+                             (int8_t)m.move.removeX, (int8_t)m.move.removeY };
+        writeBytes(coords, 4);
+        writeBytes(&m.score, 4);
+    }
+
+    void writeScoredMovesJs(const vector<ScoredMove>& moves) {
+        file << "[";
+        for (size_t i = 0; i < moves.size(); i++) {
+            const auto& m = moves[i];
+            if (i > 0) file << ", ";
+            file << "[" << m.move.moveX << "," << m.move.moveY << ","
+                 << m.move.removeX << "," << m.move.removeY << "," << m.score << "]";
+        }
+        file << "]";
+    }
+
+    void writeTurnEnd(int bestScore, const TurnSummary& sum) {
+        if (format == LOG_BINARY) {
+            curTurn.bestScore = bestScore;
+            curTurn.summaryOffset = bytesWritten;
+            writeU32(sum.timeUs);
+            writeU32((uint32_t)sum.depths.size());
+            for (const auto& d : sum.depths) {
+                writeU32(d.nodes);
+                writeU32(d.cutoffs);
+                writeU32(d.generated);
+            }
+            writeU32((uint32_t)sum.rootMoves.size());
+            for (const auto& m : sum.rootMoves) writeScoredMove(m);
+            writeU32((uint32_t)sum.pv.size());
+            for (const auto& m : sum.pv) writeScoredMove(m);
+            writeU32(sum.transpositions);
+            writeU32(sum.savedNodes);
+            writeU32((uint32_t)sum.multiplicity.size());
+            for (const auto& [id, count] : sum.multiplicity) {
+                writeBytes(&id, 4);
+                writeU32(count);
+            }
+            writeU32(sum.multiPv);
+            writeU32((uint32_t)sum.lines.size());
+            for (const auto& line : sum.lines) {
+                writeU32((uint32_t)line.size());
+                for (const auto& m : line) writeScoredMove(m);
+            }
+
+            curTurn.childIndexOffset = bytesWritten;
+            writeU32((uint32_t)childGroups.size());
+            for (const auto& g : childGroups) {
+                writeBytes(&g.parentId, 4);
+                writeU32(g.start);
+                writeU32(g.count);
+            }
+            writeU32((uint32_t)chunkOffsets.size());
+            for (uint64_t off : chunkOffsets) writeBytes(&off, 8);
+            turnIndex.push_back(curTurn);
+        } else {
+            file << "\n    ],\n";
+            file << "    \"bestScore\": " << bestScore << ",\n";
+            file << "    \"summary\": {\n";
+            file << "      \"timeUs\": " << sum.timeUs << ",\n";
+            file << "      \"depths\": [";
+            for (size_t d = 0; d < sum.depths.size(); d++) {
+                if (d > 0) file << ", ";
+                file << "{ \"nodes\": " << sum.depths[d].nodes
+                     << ", \"cutoffs\": " << sum.depths[d].cutoffs
+                     << ", \"generated\": " << sum.depths[d].generated << " }";
+            }
+            file << "],\n";
+            file << "      \"rootMoves\": ";
+            writeScoredMovesJs(sum.rootMoves);
+            file << ",\n";
+            file << "      \"pv\": ";
+            writeScoredMovesJs(sum.pv);
+            file << ",\n";
+            file << "      \"transpositions\": " << sum.transpositions << ",\n";
+            file << "      \"savedNodes\": " << sum.savedNodes << ",\n";
+            file << "      \"multiplicity\": [";
+            for (size_t i = 0; i < sum.multiplicity.size(); i++) {
+                if (i > 0) file << ", ";
+                file << "[" << sum.multiplicity[i].first << "," << sum.multiplicity[i].second << "]";
+            }
+            file << "],\n";
+            file << "      \"multiPv\": " << sum.multiPv << ",\n";
+            file << "      \"lines\": [";
+            for (size_t i = 0; i < sum.lines.size(); i++) {
+                if (i > 0) file << ", ";
+                writeScoredMovesJs(sum.lines[i]);
+            }
+            file << "]\n";
+            file << "    }\n";
+            file << "  }";
+        }
+        turnsWritten++;
+        file.flush();
+    }
+
+    void writeClose() {
+        if (format == LOG_BINARY) {
+            uint64_t indexOffset = bytesWritten;
+            for (const auto& t : turnIndex) {
+                writeBytes(&t.offset, 8);
+                writeBytes(&t.turn, 4);
+                writeBytes(&t.bestScore, 4);
+                writeU32(t.nodeCount);
+                writeU32(t.chunkCount);
+                writeBytes(&t.summaryOffset, 8);
+                writeBytes(&t.childIndexOffset, 8);
+            }
+            writeBytes(&indexOffset, 8);
+            writeU32((uint32_t)turnIndex.size());
+            writeTag("TEND");
+        } else {
+            file << "\n];\n";
+        }
+        file.flush();
+    }
+
+    void writerLoop() {
+        while (true) {
+            Job job;
+            {
+                unique_lock<mutex> lk(mtx);
+                // Yeni iş yoksa kodlaması biten chunk'ları sırayla diske yaz
+                while (jobs.empty() && !encoded.empty()) {
+                    lk.unlock();
+                    writeOldestEncoded();
+                    lk.lock();
+                }
+                jobReady.wait(lk, [&] { return !jobs.empty(); });
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+
+            // Tur başlığı/sonu, önceki düğümler yazıldıktan sonra gelmeli
+            if (job.kind != JOB_NODES) {
+                while (!encoded.empty()) writeOldestEncoded();
+            }
+
+            switch (job.kind) {
+            case JOB_TURN_BEGIN:
+                writeTurnBegin(job);
+                break;
+            case JOB_NODES:
+                writeNodes(job.nodes);
+                break;
+            case JOB_TURN_END:
+                writeTurnEnd(job.value, job.summary);
+                break;
+            case JOB_CLOSE:
+                writeClose();
+                return;
+            }
+        }
+    }
+
+    LogFormat format = LOG_BINARY;
+    string filePath;
+    ofstream file;
+    thread writer;
+    mutex mtx;
+    condition_variable jobReady;   // yazıcı bekler
+    deque<Job> jobs;
+    LogArena arena;
+    LogChunk* active = nullptr;
+    bool enabled = false;
+    int turns = 0;
+    int32_t nextNodeId = 0;
+
+    // Yalnızca yazıcı thread kullanır
+    bool firstNodeInTurn = true;
+    int turnsWritten = 0;
+    uint64_t bytesWritten = 0;
+    vector<char> chunkBytes;
+    unique_ptr<EncoderPool> encoders;             // yalnızca LOG_JS
+    deque<unique_ptr<EncodedNodes>> encoded;      // kodlanan / yazılmayı bekleyen chunk'lar
+    vector<unique_ptr<vector<char>>> textBuffers; // en fazla LOG_MAX_CHUNKS tane
+    vector<vector<char>*> freeText;
+    TurnIndex curTurn{};
+    vector<TurnIndex> turnIndex;
+    vector<ChildGroup> childGroups; // tur içi: iç düğüm başına bir kayıt
+    vector<uint64_t> chunkOffsets;
+};
+
+// Global Log Verisi
+TreeLogger treeLog;
+
+//==================================================
+// SELECTIVE CAPTURE (hangi düğümler loglanır)
+//==================================================
+// Komut satırından seçilir:
+//   ./tree              -> tüm ağaç
+//   ./tree --pv         -> sadece ana varyasyon (PV)
+//   ./tree --topk K     -> kökün en iyi K hamlesinin tam alt ağaçları (kök
+//                          penceresi --multipv K gibi açılır, yoksa ilkinden
+//                          sonraki skorlar yalnızca üst sınır olur ve seçilen
+//                          K alt ağaç en iyi K hamle olmayabilir)
+//   ./tree --depth D    -> derinliği D'ye kadar olan düğümler
+//   ./tree --sample N   -> her N düğümden biri (köke giden yoluyla birlikte)
+// Seçilmeyen düğüm logger'a hiç gitmez; PV ve top-K turun sonunda yazılır.
+//
+// --dag (tüm ağaç veya --depth ile): transpozisyonlar tekilleştirilir. Bir iç
+// düğümün pozisyonu (Zobrist anahtarı + derinlik) bu turda zaten loglandıysa
+// alt ağacı yazılmaz; yerine o düğümün id'siyle tek bir INFO_TRANSPOSITION
+// kaydı yazılır. Arama aynen devam eder, yani atlanan düğüm sayısı bir
+// transposition table'ın kazandıracağı işin üst sınırıdır (farklı alpha/beta
+// penceresinde saklanan sınır her zaman kullanılamaz).
+//
+// Yazım sırası: bir düğümün çocukları logda her zaman ardışık tek bir grup
+// olarak, düğümün kendisinden önce yer alır (kök en sonda). Düğüm kendi
+// kardeşleriyle birlikte, ebeveyni bitince yazılır; böylece yazıcı her
+// ebeveynin çocuk aralığını (başlangıç, adet) indeksleyebilir.
+enum CaptureMode { CAPTURE_ALL, CAPTURE_PV, CAPTURE_TOPK, CAPTURE_DEPTH, CAPTURE_SAMPLE };
+
+class TreeCapture {
+public:
+    CaptureMode mode = CAPTURE_ALL;
+    int param = 0;
+    bool dag = false;
+
+    void beginTurn() {
+        sampleCountdown = param;
+        keptCount = 0;
+        pending.clear();
+        for (auto& group : siblings) group.clear();
+        positions.clear();
+        refDepth = -1;
+        transpositions = savedNodes = 0;
+    }
+
+    // DAG: iç düğümün pozisyon anahtarı. Daha önce görüldüyse node.id tanım
+    // düğümünün id'si olur ve düğüm çıkışına kadar alt ağacı loglanmaz.
+    void position(LogNode& node, uint64_t key) {
+        if (!dag || refDepth >= 0) return;
+        auto [it, inserted] = positions.try_emplace(key, PositionEntry{ node.id, 1 });
+        if (inserted) return;
+        it->second.count++;
+        node.id = it->second.id;
+        refDepth = node.depth;
+    }
+
+    // Düğüme girişte (yalnızca PV ve örneklemede iş yapar)
+    void enter(int depth) {
+        if (mode == CAPTURE_PV) pvLength[depth] = 1;
+        else if (mode == CAPTURE_SAMPLE) keepPath[depth] = false;
+    }
+
+    // depth'teki düğümün en iyi çocuğu değişti: çocuğun PV'si bu düğümün PV'si olur
+    void newBest(int depth) {
+        if (mode != CAPTURE_PV) return;
+        for (int k = 0; k < pvLength[depth + 1]; k++)
+            pvLine[depth][k + 1] = pvLine[depth + 1][k];
+        pvLength[depth] = pvLength[depth + 1] + 1;
+    }
+
+    // Kök dışındaki düğümün skoru kesinleşti
+    void exit(const LogNode& n) {
+        if (refDepth >= 0) {
+            if (n.depth > refDepth) {
+                savedNodes++;
+                return;
+            }
+            // Referans düğümün kendisi: alt ağacı yerine tek kayıt
+            refDepth = -1;
+            transpositions++;
+            LogNode ref = n;
+            ref.info = INFO_TRANSPOSITION;
+            if (mode == CAPTURE_ALL || ref.depth <= param) keep(ref);
+            return;
+        }
+        switch (mode) {
+        case CAPTURE_ALL:
+        case CAPTURE_TOPK:
+            keep(n);
+            break;
+        case CAPTURE_DEPTH:
+            if (n.depth <= param) keep(n);
+            break;
+        case CAPTURE_SAMPLE:
+            // Seçilen düğümün ataları da (post-order'da sonra gelirler) tutulur
+            if (--sampleCountdown == 0 || keepPath[n.depth]) {
+                if (sampleCountdown == 0) sampleCountdown = param;
+                keepPath[n.depth - 1] = true;
+                keep(n);
+            }
+            break;
+        case CAPTURE_PV:
+            pvLine[n.depth][0] = n;
+            break;
+        }
+    }
+
+    // Kökün bir çocuğu bitti: top-K'ye girerse alt ağacı saklanır, girmezse atılır
+    void rootChildDone(int value) {
+        if (mode != CAPTURE_TOPK) return;
+        LogNode child = siblings[1].back();
+        siblings[1].pop_back();
+
+        Subtree* slot = nullptr;
+        if (keptCount < param) {
+            if ((int)kept.size() <= keptCount) kept.emplace_back();
+            slot = &kept[keptCount++];
+        } else {
+            slot = &kept[0];
+            for (int i = 1; i < keptCount; i++)
+                if (kept[i].score < slot->score) slot = &kept[i];
+            if (value <= slot->score) slot = nullptr;
+        }
+        if (slot) {
+            slot->score = value;
+            slot->root = child;
+            swap(slot->nodes, pending);
+        }
+        pending.clear(); // kapasite korunur, sonraki alt ağaç aynı belleği kullanır
+    }
+
+    // Tur sonu: biriken PV / top-K düğümleri, kökün çocuk grubu ve kök yazılır
+    void endTurn(const LogNode& root) {
+        if (mode == CAPTURE_PV) {
+            for (int k = pvLength[0] - 1; k >= 1; k--) treeLog.logNode(pvLine[0][k]);
+        } else {
+            if (mode == CAPTURE_TOPK) {
+                for (int i = 0; i < keptCount; i++) {
+                    for (const auto& n : kept[i].nodes) treeLog.logNode(n);
+                    siblings[1].push_back(kept[i].root);
+                }
+            }
+            for (const auto& n : siblings[1]) treeLog.logNode(n);
+        }
+        treeLog.logNode(root);
+    }
+
+    // DAG istatistikleri tur özetine eklenir
+    void finishSummary(TurnSummary& sum) const {
+        if (!dag) return;
+        sum.transpositions = transpositions;
+        sum.savedNodes = savedNodes;
+        for (const auto& [key, p] : positions)
+            if (p.count > 1) sum.multiplicity.push_back({ p.id, p.count });
+        sort(sum.multiplicity.begin(), sum.multiplicity.end());
+    }
+
+private:
+    struct Subtree {
+        int score;
+        LogNode root;          // kökün çocuğu
+        vector<LogNode> nodes; // onun altındaki düğümler (yazım sırasıyla)
+    };
+
+    // Düğüm tutuldu: önce bekleyen çocuk grubunu yaz, sonra kendini kardeşlerine ekle
+    void keep(const LogNode& n) {
+        if (n.depth < DEPTH_LIMIT) {
+            auto& children = siblings[n.depth + 1];
+            for (const auto& c : children) emit(c);
+            children.clear();
+        }
+        siblings[n.depth].push_back(n);
+    }
+
+    void emit(const LogNode& n) {
+        if (mode == CAPTURE_TOPK) pending.push_back(n);
+        else treeLog.logNode(n);
+    }
+
+    // siblings[d]: ebeveyni henüz bitmemiş, d derinliğindeki tutulan düğümler
+    vector<LogNode> siblings[DEPTH_LIMIT + 1];
+
+    // PV: üçgen tablo, pvLine[d] = d derinliğindeki düğümden başlayan en iyi yol
+    LogNode pvLine[DEPTH_LIMIT + 1][DEPTH_LIMIT + 1];
+    int pvLength[DEPTH_LIMIT + 1] = {};
+
+    bool keepPath[DEPTH_LIMIT + 1] = {};
+    int sampleCountdown = 0;
+
+    vector<Subtree> kept; // turlar arasında yeniden kullanılır
+    int keptCount = 0;
+    vector<LogNode> pending;
+
+    // DAG: yalnızca iç düğümler (~%1) anahtarlanır; yaprak referansı yaprağın kendisi kadar yer tutar
+    struct PositionEntry {
+        int32_t  id;
+        uint32_t count;
+    };
+    unordered_map<uint64_t, PositionEntry> positions;
+    int refDepth = -1;      // >= 0: bu derinlikteki referans düğümün alt ağacındayız
+    uint32_t transpositions = 0;
+    uint32_t savedNodes = 0;
+};
+
+TreeCapture capture;
 
 //==================================================
 // HELPER FUNCTIONS
@@ -311,29 +1109,142 @@ vector<Move> generateAllMoves(const State& s) {
     return res;
 }
 
+//==================================================
+// POSITION HASH (ZOBRIST, DAG loglaması için)
+//==================================================
+// Sabit tohumlu splitmix64 ile üretilir; anahtar tur içinde karşılaştırılır,
+// çalıştırmalar arası kararlı olması yeterli.
+struct ZobristTable {
+    uint64_t cell[N][N][3];          // 0: engel, 1: AI piyonu, 2: insan piyonu
+    uint64_t maxTurn;
+    uint64_t depth[DEPTH_LIMIT + 1];
+};
+
+ZobristTable makeZobrist() {
+    ZobristTable z{};
+    uint64_t x = 0x9E3779B97F4A7C15ull;
+    auto next = [&x] {
+        uint64_t r = (x += 0x9E3779B97F4A7C15ull);
+        r = (r ^ (r >> 30)) * 0xBF58476D1CE4E5B9ull;
+        r = (r ^ (r >> 27)) * 0x94D049BB133111EBull;
+        return r ^ (r >> 31);
+    };
+    for (auto& row : z.cell) for (auto& c : row) for (auto& k : c) k = next();
+    z.maxTurn = next();
+    for (auto& d : z.depth) d = next();
+    return z;
+}
+
+const ZobristTable ZOBRIST = makeZobrist();
+
+// Aynı pozisyon farklı kalan derinlikte farklı alt ağaç demek: derinlik de anahtarda
+uint64_t positionKey(const State& s, int nodeDepth) {
+    uint64_t h = ZOBRIST.depth[nodeDepth];
+    for (int i = 0; i < N; i++) {
+        for (int j = 0; j < N; j++) {
+            int v = s.board[i][j];
+            if (v == BLOCKED) h ^= ZOBRIST.cell[i][j][0];
+            else if (v == AI_PAWN) h ^= ZOBRIST.cell[i][j][1];
+            else if (v == HU_PAWN) h ^= ZOBRIST.cell[i][j][2];
+        }
+    }
+    if (s.isMaxTurn) h ^= ZOBRIST.maxTurn;
+    return h;
+}
+
+//==================================================
+// SEARCH STATISTICS (TurnSummary için)
+//==================================================
+class SearchStats {
+public:
+    void beginTurn() {
+        for (auto& d : depths) d = {};
+        rootMoves.clear();
+        rootPvs.clear();
+        start = chrono::steady_clock::now();
+    }
+
+    void enter(int depth) {
+        depths[depth].nodes++;
+        pvLength[depth] = 0;
+    }
+    void generated(int depth, size_t count) { depths[depth].generated += (uint32_t)count; }
+    void cutoff(int depth) { depths[depth].cutoffs++; }
+    // Kök hamlesi bitti: çocuğun PV'si (pv[1]) de saklanır, multi-PV satırları için
+    void rootMove(const Move& m, int score) {
+        rootMoves.push_back({ m, score });
+        rootPvs.emplace_back(pv[1], pv[1] + pvLength[1]);
+    }
+
+    // depth'teki düğümün en iyi hamlesi m oldu: PV = m + çocuğun PV'si
+    void newBest(int depth, const Move& m, int score) {
+        pv[depth][0] = { m, score };
+        for (int k = 0; k < pvLength[depth + 1]; k++) pv[depth][k + 1] = pv[depth + 1][k];
+        pvLength[depth] = pvLength[depth + 1] + 1;
+    }
+
+    // lineCount: en iyi kaç kök hamlesinin satırı yazılır (skorları kesin olanlar)
+    TurnSummary finish(int lineCount) {
+        TurnSummary sum;
+        sum.timeUs = (uint32_t)chrono::duration_cast<chrono::microseconds>(
+            chrono::steady_clock::now() - start).count();
+        sum.depths.assign(depths, depths + DEPTH_LIMIT + 1);
+        sum.rootMoves = rootMoves;
+        sum.pv.assign(pv[0], pv[0] + pvLength[0]);
+
+        vector<size_t> order(rootMoves.size());
+        for (size_t i = 0; i < order.size(); i++) order[i] = i;
+        stable_sort(order.begin(), order.end(),
+                    [&](size_t a, size_t b) { return rootMoves[a].score > rootMoves[b].score; });
+        sum.multiPv = (uint32_t)lineCount;
+        for (size_t k = 0; k < order.size() && (int)k < lineCount; k++) {
+            vector<ScoredMove> line = { rootMoves[order[k]] };
+            line.insert(line.end(), rootPvs[order[k]].begin(), rootPvs[order[k]].end());
+            sum.lines.push_back(line);
+        }
+        return sum;
+    }
+
+private:
+    DepthStats depths[DEPTH_LIMIT + 1] = {};
+    ScoredMove pv[DEPTH_LIMIT + 1][DEPTH_LIMIT + 1];
+    int pvLength[DEPTH_LIMIT + 2] = {};
+    vector<ScoredMove> rootMoves;
+    vector<vector<ScoredMove>> rootPvs; // rootMoves[i]'nin çocuğunun PV'si
+    chrono::steady_clock::time_point start;
+};
+
+SearchStats searchStats;
+
 //==================================================
 // MINIMAX (LOGLAMA İLE)
 //==================================================
 int minimax(const State& s, int depth, int alpha, int beta, int parentId) {
     
-    // 1. Düğümü oluştur ve kaydet
-    int myId = (int)currentTurnNodes.size();
-    currentTurnNodes.push_back({
-        myId, parentId, 0, DEPTH_LIMIT - depth,
-        s.isMaxTurn ? "MAX" : "MIN", ""
-    });
+    // 1. Düğümü oluştur; skor belli olunca (çıkışta) logger'a akıtılır
+    LogNode node{
+        treeLog.newNodeId(), parentId, 0, (uint8_t)(DEPTH_LIMIT - depth),
+        s.isMaxTurn ? NODE_MAX : NODE_MIN, INFO_NONE, 0
+    };
+    capture.enter(node.depth);
+    searchStats.enter(node.depth);
 
     if (depth == 0 || hasNoMoves(s)) {
         int v = eval(s);
-        currentTurnNodes[myId].score = v;
-        currentTurnNodes[myId].info = "Leaf";
+        node.score = v;
+        node.info = INFO_LEAF;
+        capture.exit(node);
         return v;
     }
 
+    capture.position(node, positionKey(s, node.depth));
+
     auto moves = generateAllMoves(s);
+    searchStats.generated(node.depth, moves.size());
     if (moves.empty()) {
         int v = eval(s);
-        currentTurnNodes[myId].score = v;
+        node.score = v;
+        capture.exit(node);
         return v;
     }
 
@@ -341,77 +1252,94 @@ int minimax(const State& s, int depth, int alpha, int beta, int parentId) {
         int best = -1000000000;
         for (const auto& m : moves) {
             State child = applyMove(s, m);
-            int val = minimax(child, depth - 1, alpha, beta, myId);
+            int val = minimax(child, depth - 1, alpha, beta, node.id);
 
-            best = max(best, val);
+            if (val > best) {
+                best = val;
+                capture.newBest(node.depth);
+                searchStats.newBest(node.depth, m, val);
+            }
             alpha = max(alpha, val);
 
             if (beta <= alpha) {
-                currentTurnNodes[myId].info = "Pruned (Beta)";
+                node.info = INFO_PRUNED_BETA;
+                searchStats.cutoff(node.depth);
                 break;
             }
         }
-        currentTurnNodes[myId].score = best;
+        node.score = best;
+        capture.exit(node);
         return best;
     } 
     else { // MIN
         int best = 1000000000;
         for (const auto& m : moves) {
             State child = applyMove(s, m);
-            int val = minimax(child, depth - 1, alpha, beta, myId);
+            int val = minimax(child, depth - 1, alpha, beta, node.id);
 
-            best = min(best, val);
+            if (val < best) {
+                best = val;
+                capture.newBest(node.depth);
+                searchStats.newBest(node.depth, m, val);
+            }
             beta = min(beta, val);
 
             if (beta <= alpha) {
-                currentTurnNodes[myId].info = "Pruned (Alpha)";
+                node.info = INFO_PRUNED_ALPHA;
+                searchStats.cutoff(node.depth);
                 break;
             }
         }
-        currentTurnNodes[myId].score = best;
+        node.score = best;
+        capture.exit(node);
         return best;
     }
 }
 
+// --multipv K: kök penceresinin alt sınırı en iyi değil K'ncı en iyi skor,
+// böylece en iyi K kök hamlesinin skoru kesin olur (geri kalanlar yine sınır).
+// K = 1 düz alpha-beta.
+int multiPv = 1;
+
 Move findBestMove(const State& s, int depth) {
-    currentTurnNodes.clear();
+    // LOG: tur başlığı (o anki tahta) aramadan önce yazılır
+    treeLog.beginTurn(treeLog.turnCount() + 1, s.board);
+    capture.beginTurn();
+    searchStats.beginTurn();
 
     // ROOT NODE
-    int rootId = 0;
-    currentTurnNodes.push_back({ rootId, -1, 0, 0, "ROOT", "Start" });
+    int rootId = treeLog.newNodeId();
+    capture.enter(0);
+    searchStats.enter(0);
 
     auto moves = generateAllMoves(s);
+    searchStats.generated(0, moves.size());
     Move best{};
     int bestVal = -1000000000;
     int alpha = -1000000000, beta = 1000000000;
+    vector<int> topScores; // en iyi K skor, büyükten küçüğe
 
     for (const auto& m : moves) {
         State child = applyMove(s, m);
         int val = minimax(child, depth - 1, alpha, beta, rootId);
+        capture.rootChildDone(val);
+        searchStats.rootMove(m, val);
 
         if (val > bestVal) {
             bestVal = val;
             best = m;
+            capture.newBest(0);
+            searchStats.newBest(0, m, val);
         }
-        alpha = max(alpha, val);
+        topScores.insert(upper_bound(topScores.begin(), topScores.end(), val, greater<int>()), val);
+        if ((int)topScores.size() > multiPv) topScores.pop_back();
+        if ((int)topScores.size() == multiPv) alpha = topScores.back();
     }
-    
-    if(!currentTurnNodes.empty()) currentTurnNodes[0].score = bestVal;
 
-    // LOG KAYDI
-    LogTurn turnLog;
-    turnLog.turnNumber = (int)gameLog.size() + 1;
-    turnLog.nodes = currentTurnNodes;
-    turnLog.bestMoveScore = bestVal;
-    
-    // Board state kopyala
-    for(int i=0; i<N; i++) {
-        for(int j=0; j<N; j++) {
-            turnLog.boardState[i][j] = s.board[i][j];
-        }
-    }
-    
-    gameLog.push_back(turnLog);
+    capture.endTurn({ rootId, -1, bestVal, 0, NODE_ROOT, INFO_START, 0 });
+    TurnSummary summary = searchStats.finish(multiPv);
+    capture.finishSummary(summary);
+    treeLog.endTurn(bestVal, std::move(summary));
 
     return best;
 }
@@ -444,10 +1372,102 @@ void initializeGame(State& s) {
     s.isMaxTurn = false; 
 }
 
+//==================================================
+// GAME RECORD (games.m3g, m3.cpp'deki GAME RECORDS formatı)
+//==================================================
+// Ağaç dökümünün yanında oyunun kendisi: başlangıç, hamle listesi
+// (adım / engel) ve sonuç (ai, hu; pencere oyun bitmeden kapanırsa *).
+void appendGameRecord(const char* path, const State& start, const vector<Move>& moves, const State& final) {
+    ofstream out(path, ios::app);
+    if (!out) return;
+    out << "start " << N << " ai " << start.aiX << ',' << start.aiY << " hu " << start.huX << ',' << start.huY
+        << " tomove " << (start.isMaxTurn ? "ai" : "hu") << "\nmoves";
+    for (const Move& m : moves)
+        out << ' ' << m.moveX << ',' << m.moveY << '/' << m.removeX << ',' << m.removeY;
+    out << "\nresult " << (!hasNoMoves(final) ? "*" : final.isMaxTurn ? "hu" : "ai") << "\n\n";
+}
+
 //==================================================
 // MAIN
 //==================================================
-int main() {
+// Komut satırı: yakalama modu (bkz. SELECTIVE CAPTURE)
+bool parseCaptureArgs(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if (arg == "--pv") {
+            capture.mode = CAPTURE_PV;
+        } else if (arg == "--topk" && hasValue) {
+            capture.mode = CAPTURE_TOPK;
+            capture.param = atoi(argv[++i]);
+        } else if (arg == "--depth" && hasValue) {
+            capture.mode = CAPTURE_DEPTH;
+            capture.param = atoi(argv[++i]);
+        } else if (arg == "--sample" && hasValue) {
+            capture.mode = CAPTURE_SAMPLE;
+            capture.param = atoi(argv[++i]);
+        } else if (arg == "--dag") {
+            capture.dag = true;
+        } else if (arg == "--multipv" && hasValue) {
+            multiPv = atoi(argv[++i]);
+            if (multiPv < 1) return false;
+        } else {
+            return false;
+        }
+    }
+    // top-K sıralaması kesin skor ister: en az K kök hamlesi kesin aranır
+    if (capture.mode == CAPTURE_TOPK) multiPv = max(multiPv, capture.param);
+    // PV/top-K/örneklemede tanım düğümü atılmış olabilir, referansı boşa düşer
+    if (capture.dag && capture.mode != CAPTURE_ALL && capture.mode != CAPTURE_DEPTH) return false;
+    if (capture.mode == CAPTURE_TOPK || capture.mode == CAPTURE_SAMPLE) return capture.param >= 1;
+    if (capture.mode == CAPTURE_DEPTH) return capture.param >= 0;
+    return true;
+}
+
+// ./tree --bench-json [düğüm]: sentetik bir turu game_data.js formatında
+// yazar ve kodlama + yazma hızını (MB/s) ölçer.
+void runJsonBenchmark(int nodeCount) {
+    const char* path = "bench_game_data.js";
+    TreeLogger bench;
+    if (!bench.open(path, LOG_JS)) {
+        cout << "Hata: " << path << " oluşturulamadı!" << endl;
+        return;
+    }
+
+    int board[N][N] = {};
+    uint32_t x = 12345;
+    auto start = chrono::steady_clock::now();
+
+    bench.beginTurn(1, board);
+    for (int i = 0; i < nodeCount; i++) {
+        x = x * 1664525u + 1013904223u;
+        uint8_t depth = (uint8_t)(1 + x % DEPTH_LIMIT);
+        bench.logNode({ i + 1, (int)(x >> 12) % (i + 1), (int)(x >> 8) % 20001 - 10000, depth,
+                        depth % 2 ? NODE_MIN : NODE_MAX, (NodeInfo)(x % 5), 0 });
+    }
+    bench.endTurn(0, {});
+    bench.close();
+
+    double secs = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    ifstream in(path, ios::binary | ios::ate);
+    double mb = (double)in.tellg() / (1024.0 * 1024.0);
+    cout << "JSON benchmark: " << nodeCount << " düğüm, " << mb << " MB, "
+         << secs * 1000.0 << " ms, " << mb / secs << " MB/s" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc >= 2 && string(argv[1]) == "--bench-json") {
+        runJsonBenchmark(argc >= 3 ? atoi(argv[2]) : 5000000);
+        return 0;
+    }
+
+    if (!parseCaptureArgs(argc, argv)) {
+        cout << "Kullanim: ./tree [--pv | --topk K | --depth D | --sample N] [--dag] [--multipv K]" << endl;
+        cout << "          (--dag yalnizca tum agac veya --depth ile)" << endl;
+        cout << "          ./tree --bench-json [dugum sayisi]" << endl;
+        return 1;
+    }
+
     sf::RenderWindow window(
         sf::VideoMode({ (unsigned int)(N * CELL),
                         (unsigned int)(N * CELL + UI_HEIGHT) }),
@@ -455,6 +1475,10 @@ int main() {
     );
     window.setFramerateLimit(60);
 
+    if (!treeLog.open(LOG_FORMAT == LOG_BINARY ? "game_data.bin" : "game_data.js", LOG_FORMAT)) {
+        cout << "Hata: Dosya oluşturulamadı!" << endl;
+    }
+
     sf::Font font;
     if (!font.openFromFile("arial.ttf")) {
         if (!font.openFromFile("/Library/Fonts/Arial.ttf")) {
@@ -470,13 +1494,25 @@ int main() {
     State game;
     initializeGame(game);
 
+    State startPosition = game;
+    State lastComplete = game; // son tam hamleden sonra (kapanış adımla engel arasında gelebilir)
+    vector<Move> played;
+    bool recorded = false;     // kapanış ve oyun sonu aynı turda gelebilir: kayıt bir kez
+    auto recordGame = [&] {
+        if (recorded || played.empty()) return;
+        appendGameRecord("games.m3g", startPosition, played, lastComplete);
+        recorded = true;
+    };
+    Move humanMove{};
+
     int depthLimit = DEPTH_LIMIT;
     int hStage = 0;
 
     while (window.isOpen()) {
         while (const std::optional<sf::Event> event = window.pollEvent()) {
             if (event->is<sf::Event::Closed>()) {
-                saveGameLog(); // Çıkışta kaydet
+                recordGame();
+                treeLog.close(); // Çıkışta kalan tamponları yaz
                 window.close();
             }
 
@@ -492,6 +1528,8 @@ int main() {
                                 for (auto p : steps) {
                                     if (p.first == gx && p.second == gy) {
                                         applyStepMove(game, gx, gy);
+                                        humanMove.moveX = gx;
+                                        humanMove.moveY = gy;
                                         hStage = 1;
                                         break;
                                     }
@@ -500,7 +1538,11 @@ int main() {
                             else if (hStage == 1) {
                                 if (game.board[gx][gy] == EMPTY) {
                                     placeBarrier(game, gx, gy);
+                                    humanMove.removeX = gx;
+                                    humanMove.removeY = gy;
+                                    played.push_back(humanMove);
                                     game.isMaxTurn = true;
+                                    lastComplete = game;
                                     hStage = 0;
                                 }
                             }
@@ -517,7 +1559,8 @@ int main() {
             window.display();
             sf::sleep(sf::milliseconds(1000));
             
-            saveGameLog();
+            recordGame();
+            treeLog.close();
             window.close();
             break;
         }
@@ -532,8 +1575,10 @@ int main() {
 
             Move ai = findBestMove(game, depthLimit);
             game = applyMove(game, ai);
+            played.push_back(ai);
+            lastComplete = game;
             
-            cout << "Turn " << gameLog.size() << " loglandi." << endl;
+            cout << "Turn " << treeLog.turnCount() << " loglandi." << endl;
             if (font.getInfo().family != "") infoText.setString("AI Hamle Yapti.");
         }
 